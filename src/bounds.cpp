@@ -0,0 +1,162 @@
+#include "bounds.h"
+
+#include <float.h>
+
+// Extreme points are searched along the axes and the box diagonals.
+const u32 kExtremeDirectionCount = 7u;
+
+const u32 kSphereRefinementCount = 8u;
+const f32 kSphereShrinkFactor = 0.2f;
+
+static v3 getPoint(
+	const f32* _pPositions,
+	size_t _positionStride,
+	const u32* _pIndices,
+	size_t _pointIndex)
+{
+	size_t index = _pIndices ? _pIndices[_pointIndex] : _pointIndex;
+	const f32* pPosition = (const f32*)((const u8*)_pPositions + index * _positionStride);
+
+	return v3(pPosition[0], pPosition[1], pPosition[2]);
+}
+
+// Each point outside the sphere moves it towards the point just enough to contain both, so the sphere never shrinks.
+// Points are visited from a different start each time, since the result depends on their order.
+static void growSphere(
+	BoundingSphere& _rSphere,
+	const f32* _pPositions,
+	size_t _positionStride,
+	const u32* _pIndices,
+	size_t _pointCount,
+	size_t _firstPoint)
+{
+	for (size_t i = 0; i < _pointCount; ++i)
+	{
+		v3 point = getPoint(_pPositions, _positionStride, _pIndices, (_firstPoint + i) % _pointCount);
+		v3 direction = point - _rSphere.center;
+
+		f32 distanceSquared = glm::dot(direction, direction);
+		if (distanceSquared <= _rSphere.radius * _rSphere.radius)
+		{
+			continue;
+		}
+
+		f32 distance = glm::sqrt(distanceSquared);
+		f32 radius = 0.5f * (_rSphere.radius + distance);
+
+		_rSphere.center += direction * ((radius - _rSphere.radius) / distance);
+		_rSphere.radius = radius;
+	}
+}
+
+// Growing accumulates rounding errors, so the final radius is measured exactly around the final center.
+static f32 calculateEnclosingRadius(
+	v3 _center,
+	const f32* _pPositions,
+	size_t _positionStride,
+	const u32* _pIndices,
+	size_t _pointCount)
+{
+	f32 maxDistanceSquared = 0.0f;
+
+	for (size_t pointIndex = 0; pointIndex < _pointCount; ++pointIndex)
+	{
+		v3 direction = getPoint(_pPositions, _positionStride, _pIndices, pointIndex) - _center;
+		maxDistanceSquared = glm::max(maxDistanceSquared, glm::dot(direction, direction));
+	}
+
+	return glm::sqrt(maxDistanceSquared);
+}
+
+BoundingSphere calculateBoundingSphere(
+	const f32* _pPositions,
+	size_t _positionStride,
+	const u32* _pIndices,
+	size_t _pointCount)
+{
+	if (_pointCount == 0u)
+	{
+		return {};
+	}
+
+	const v3 kExtremeDirections[kExtremeDirectionCount] = {
+		v3(1.0f, 0.0f, 0.0f),
+		v3(0.0f, 1.0f, 0.0f),
+		v3(0.0f, 0.0f, 1.0f),
+		v3(1.0f, 1.0f, 1.0f),
+		v3(1.0f, 1.0f, -1.0f),
+		v3(1.0f, -1.0f, 1.0f),
+		v3(1.0f, -1.0f, -1.0f) };
+
+	std::array<v3, kExtremeDirectionCount> minPoints;
+	std::array<v3, kExtremeDirectionCount> maxPoints;
+	std::array<f32, kExtremeDirectionCount> minProjections;
+	std::array<f32, kExtremeDirectionCount> maxProjections;
+
+	minProjections.fill(FLT_MAX);
+	maxProjections.fill(-FLT_MAX);
+
+	for (size_t pointIndex = 0; pointIndex < _pointCount; ++pointIndex)
+	{
+		v3 point = getPoint(_pPositions, _positionStride, _pIndices, pointIndex);
+
+		for (u32 directionIndex = 0; directionIndex < kExtremeDirectionCount; ++directionIndex)
+		{
+			f32 projection = glm::dot(point, kExtremeDirections[directionIndex]);
+
+			if (projection < minProjections[directionIndex])
+			{
+				minProjections[directionIndex] = projection;
+				minPoints[directionIndex] = point;
+			}
+
+			if (projection > maxProjections[directionIndex])
+			{
+				maxProjections[directionIndex] = projection;
+				maxPoints[directionIndex] = point;
+			}
+		}
+	}
+
+	u32 widestDirection = 0u;
+	f32 widestDistanceSquared = -1.0f;
+
+	for (u32 directionIndex = 0; directionIndex < kExtremeDirectionCount; ++directionIndex)
+	{
+		v3 extent = maxPoints[directionIndex] - minPoints[directionIndex];
+		f32 distanceSquared = glm::dot(extent, extent);
+
+		if (distanceSquared > widestDistanceSquared)
+		{
+			widestDistanceSquared = distanceSquared;
+			widestDirection = directionIndex;
+		}
+	}
+
+	BoundingSphere sphere = {
+		.center = 0.5f * (minPoints[widestDirection] + maxPoints[widestDirection]),
+		.radius = 0.5f * glm::sqrt(widestDistanceSquared) };
+
+	growSphere(sphere, _pPositions, _positionStride, _pIndices, _pointCount, 0u);
+	sphere.radius = calculateEnclosingRadius(sphere.center, _pPositions, _positionStride, _pIndices, _pointCount);
+
+	for (u32 refinementIndex = 0; refinementIndex < kSphereRefinementCount; ++refinementIndex)
+	{
+		// Shrinking less every time lets the first refinements escape Ritter's local optimum, while later ones fine tune it.
+		BoundingSphere refinedSphere = {
+			.center = sphere.center,
+			.radius = sphere.radius * (1.0f - kSphereShrinkFactor / f32(refinementIndex + 1)) };
+
+		size_t firstPoint = (refinementIndex + 1) * _pointCount / (kSphereRefinementCount + 1);
+		growSphere(refinedSphere, _pPositions, _positionStride, _pIndices, _pointCount, firstPoint);
+
+		refinedSphere.radius = calculateEnclosingRadius(refinedSphere.center, _pPositions, _positionStride, _pIndices, _pointCount);
+
+		if (refinedSphere.radius < sphere.radius)
+		{
+			sphere = refinedSphere;
+		}
+	}
+
+	return sphere;
+}
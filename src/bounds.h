@@ -0,0 +1,18 @@
+#pragma once
+
+// Near minimal bounding spheres. Ritter's sphere is grown from the most distant pair of extreme points
+// along a fixed set of directions, then refined by repeatedly shrinking it and growing it back over all points.
+// See "Fast and Tight Fitting Bounding Spheres" by Thomas Larsson.
+
+struct BoundingSphere
+{
+	v3 center{};
+	f32 radius = 0.0f;
+};
+
+// Points are read with a byte stride, through indices when they are provided.
+BoundingSphere calculateBoundingSphere(
+	const f32* _pPositions,
+	size_t _positionStride,
+	const u32* _pIndices,
+	size_t _pointCount);
@@ -0,0 +1,407 @@
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "mesh_import.h"
+#include "cluster_hierarchy.h"
+#include "bounds.h"
+#include "job_system.h"
+#include "utils.h"
+
+#include <meshoptimizer.h>
+#include <metis.h>
+#include <float.h>
+#include <mutex>
+#include <unordered_map>
+
+// Clusters merged into a single group, which is simplified to roughly half of its triangles.
+const u32 kClusterGroupSize = 4u;
+
+const u32 kMaxClusterLevels = 16u;
+
+// Groups which can't be simplified below this ratio of their triangles are left as roots.
+const f32 kMinClusterGroupReduction = 0.85f;
+
+// METIS keeps some of its allocation bookkeeping in globals.
+static std::mutex gMetisMutex;
+
+struct ClusterGroupResult
+{
+	bool bSimplified = false;
+	v4 bounds{};
+	f32 error = 0.0f;
+	std::vector<Meshlet> meshlets;
+	std::vector<u32> meshletVertices;
+	std::vector<u8> meshletTriangles;
+};
+
+static v4 mergeSpheres(
+	v4 _first,
+	v4 _second)
+{
+	f32 distance = glm::distance(v3(_first), v3(_second));
+
+	if (distance + _second.w <= _first.w)
+	{
+		return _first;
+	}
+
+	if (distance + _first.w <= _second.w)
+	{
+		return _second;
+	}
+
+	f32 radius = 0.5f * (distance + _first.w + _second.w);
+	v3 center = v3(_first) + (v3(_second) - v3(_first)) * ((radius - _first.w) / distance);
+
+	return v4(center, radius);
+}
+
+static std::vector<u32> getMeshletIndices(
+	const Meshlet& _rMeshlet,
+	const u32* _pMeshletVertices,
+	const u8* _pMeshletTriangles)
+{
+	std::vector<u32> indices(3 * size_t(_rMeshlet.triangleCount));
+
+	for (u32 index = 0; index < indices.size(); ++index)
+	{
+		indices[index] = _pMeshletVertices[_rMeshlet.vertexOffset + _pMeshletTriangles[_rMeshlet.triangleOffset + index]];
+	}
+
+	return indices;
+}
+
+// Clusters are graph nodes, connected by edges weighted with the number of triangle edges they share.
+// Triangle edges are keyed by position, so clusters split along texture seams are still neighbours.
+static std::vector<std::vector<u32>> partitionClusters(
+	std::vector<u32>& _rClusters,
+	std::vector<std::vector<u32>>& _rClusterIndices,
+	std::vector<u32>& _rPositionRemap)
+{
+	if (_rClusters.size() <= kClusterGroupSize)
+	{
+		return { _rClusters };
+	}
+
+	u32 clusterCount = u32(_rClusters.size());
+
+	std::unordered_map<u64, u32> edgeOwners;
+	std::vector<std::map<u32, u32>> adjacency(clusterCount);
+
+	for (u32 localCluster = 0; localCluster < clusterCount; ++localCluster)
+	{
+		std::vector<u32>& rIndices = _rClusterIndices[_rClusters[localCluster]];
+
+		for (size_t triangle = 0; triangle < rIndices.size(); triangle += 3)
+		{
+			for (u32 edge = 0; edge < 3; ++edge)
+			{
+				u32 first = _rPositionRemap[rIndices[triangle + edge]];
+				u32 second = _rPositionRemap[rIndices[triangle + (edge + 1) % 3]];
+
+				if (first == second)
+				{
+					continue;
+				}
+
+				u64 edgeKey = (u64(glm::min(first, second)) << 32) | u64(glm::max(first, second));
+				auto [edgeOwner, bInserted] = edgeOwners.try_emplace(edgeKey, localCluster);
+
+				if (!bInserted && edgeOwner->second != localCluster)
+				{
+					++adjacency[localCluster][edgeOwner->second];
+					++adjacency[edgeOwner->second][localCluster];
+				}
+			}
+		}
+	}
+
+	std::vector<idx_t> adjacencyOffsets;
+	std::vector<idx_t> adjacencyNodes;
+	std::vector<idx_t> adjacencyWeights;
+
+	for (u32 localCluster = 0; localCluster < clusterCount; ++localCluster)
+	{
+		adjacencyOffsets.push_back(idx_t(adjacencyNodes.size()));
+
+		for (auto [neighbour, weight] : adjacency[localCluster])
+		{
+			adjacencyNodes.push_back(idx_t(neighbour));
+			adjacencyWeights.push_back(idx_t(weight));
+		}
+	}
+
+	adjacencyOffsets.push_back(idx_t(adjacencyNodes.size()));
+
+	idx_t nodeCount = idx_t(clusterCount);
+	idx_t constraintCount = 1;
+	idx_t partCount = idx_t(divideRoundingUp(clusterCount, kClusterGroupSize));
+	idx_t edgeCut = 0;
+
+	idx_t options[METIS_NOPTIONS];
+	METIS_SetDefaultOptions(options);
+
+	// Fixed seed, so the hierarchy is deterministic and cache files stay reproducible.
+	options[METIS_OPTION_SEED] = 42;
+
+	std::vector<idx_t> parts(clusterCount);
+
+	{
+		std::lock_guard<std::mutex> lock(gMetisMutex);
+
+		i32 result = METIS_PartGraphKway(&nodeCount, &constraintCount, adjacencyOffsets.data(), adjacencyNodes.data(),
+			nullptr, nullptr, adjacencyWeights.data(), &partCount, nullptr, nullptr, options, &edgeCut, parts.data());
+		assert(result == METIS_OK);
+	}
+
+	std::vector<std::vector<u32>> groups(partCount);
+
+	for (u32 localCluster = 0; localCluster < clusterCount; ++localCluster)
+	{
+		groups[parts[localCluster]].push_back(_rClusters[localCluster]);
+	}
+
+	std::erase_if(groups, [](std::vector<u32>& _rGroup) { return _rGroup.empty(); });
+
+	return groups;
+}
+
+// Group vertices are compacted first, since simplification and meshlet building scale with the vertex count.
+static void simplifyClusterGroup(
+	ClusterGroupResult& _rResult,
+	std::vector<u32>& _rGroup,
+	ClusterHierarchy& _rHierarchy,
+	std::vector<std::vector<u32>>& _rClusterIndices,
+	const RawVertex* _pVertices,
+	f32 _coneWeight)
+{
+	std::vector<u32> groupVertices;
+	std::vector<u32> indices;
+	std::unordered_map<u32, u32> localVertices;
+
+	for (u32 clusterIndex : _rGroup)
+	{
+		for (u32 index : _rClusterIndices[clusterIndex])
+		{
+			auto [localVertex, bInserted] = localVertices.try_emplace(index, u32(groupVertices.size()));
+
+			if (bInserted)
+			{
+				groupVertices.push_back(index);
+			}
+
+			indices.push_back(localVertex->second);
+		}
+	}
+
+	std::vector<v3> positions(groupVertices.size());
+
+	for (size_t vertex = 0; vertex < groupVertices.size(); ++vertex)
+	{
+		const RawVertex& rVertex = _pVertices[groupVertices[vertex]];
+		positions[vertex] = v3(rVertex.position[0], rVertex.position[1], rVertex.position[2]);
+	}
+
+	// Group borders are locked, so neighbouring groups still match after either of them gets simplified.
+	std::vector<u32> simplifiedIndices(indices.size());
+	f32 simplificationError = 0.0f;
+
+	size_t targetIndexCount = (indices.size() / 6) * 3;
+	simplifiedIndices.resize(meshopt_simplify(simplifiedIndices.data(), indices.data(), indices.size(),
+		&positions[0].x, positions.size(), sizeof(v3), targetIndexCount, FLT_MAX, meshopt_SimplifyLockBorder, &simplificationError));
+
+	if (simplifiedIndices.empty() || simplifiedIndices.size() > size_t(indices.size() * kMinClusterGroupReduction))
+	{
+		return;
+	}
+
+	// Children bounds and errors are merged, so both grow monotonically towards the root.
+	_rResult.bounds = v4(0.0f, 0.0f, 0.0f, -1.0f);
+	_rResult.error = 0.0f;
+
+	for (u32 clusterIndex : _rGroup)
+	{
+		Cluster& rCluster = _rHierarchy.clusters[clusterIndex];
+		v4 clusterBounds(rCluster.center[0], rCluster.center[1], rCluster.center[2], rCluster.radius);
+
+		_rResult.bounds = _rResult.bounds.w < 0.0f ? clusterBounds : mergeSpheres(_rResult.bounds, clusterBounds);
+		_rResult.error = glm::max(_rResult.error, rCluster.error);
+	}
+
+	_rResult.error += simplificationError * meshopt_simplifyScale(&positions[0].x, positions.size(), sizeof(v3));
+
+	size_t maxMeshlets = meshopt_buildMeshletsBound(simplifiedIndices.size(), kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet);
+	std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+	_rResult.meshletVertices.resize(maxMeshlets * kMaxVerticesPerMeshlet);
+	_rResult.meshletTriangles.resize(maxMeshlets * kMaxTrianglesPerMeshlet * 3);
+
+	size_t meshletCount = meshopt_buildMeshlets(meshlets.data(), _rResult.meshletVertices.data(), _rResult.meshletTriangles.data(),
+		simplifiedIndices.data(), simplifiedIndices.size(), &positions[0].x, positions.size(), sizeof(v3),
+		kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet, _coneWeight);
+
+	meshopt_Meshlet& rLastMeshlet = meshlets[meshletCount - 1];
+
+	_rResult.meshletVertices.resize(rLastMeshlet.vertex_offset + size_t(rLastMeshlet.vertex_count));
+	_rResult.meshletTriangles.resize(rLastMeshlet.triangle_offset + ((size_t(rLastMeshlet.triangle_count) * 3 + 3) & ~3));
+	meshlets.resize(meshletCount);
+
+	for (meshopt_Meshlet& rMeshlet : meshlets)
+	{
+		meshopt_Bounds bounds = meshopt_computeMeshletBounds(&_rResult.meshletVertices[rMeshlet.vertex_offset],
+			&_rResult.meshletTriangles[rMeshlet.triangle_offset], rMeshlet.triangle_count,
+			&positions[0].x, positions.size(), sizeof(v3));
+
+		BoundingSphere sphere = calculateBoundingSphere(&positions[0].x, sizeof(v3),
+			&_rResult.meshletVertices[rMeshlet.vertex_offset], rMeshlet.vertex_count);
+
+		Meshlet meshlet{};
+		meshlet.vertexOffset = rMeshlet.vertex_offset;
+		meshlet.triangleOffset = rMeshlet.triangle_offset;
+		meshlet.vertexCount = rMeshlet.vertex_count;
+		meshlet.triangleCount = rMeshlet.triangle_count;
+
+		meshlet.center[0] = sphere.center.x;
+		meshlet.center[1] = sphere.center.y;
+		meshlet.center[2] = sphere.center.z;
+		meshlet.radius = sphere.radius;
+
+		meshlet.coneAxis[0] = bounds.cone_axis_s8[0];
+		meshlet.coneAxis[1] = bounds.cone_axis_s8[1];
+		meshlet.coneAxis[2] = bounds.cone_axis_s8[2];
+		meshlet.coneCutoff = bounds.cone_cutoff_s8;
+
+		_rResult.meshlets.push_back(meshlet);
+	}
+
+	for (u32& rMeshletVertex : _rResult.meshletVertices)
+	{
+		rMeshletVertex = groupVertices[rMeshletVertex];
+	}
+
+	_rResult.bSimplified = true;
+}
+
+void buildClusterHierarchy(
+	ClusterHierarchy& _rHierarchy,
+	const Meshlet* _pMeshlets,
+	u32 _meshletCount,
+	const u32* _pMeshletVertices,
+	const u8* _pMeshletTriangles,
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	f32 _coneWeight)
+{
+	EASY_BLOCK("BuildClusterHierarchy");
+
+	_rHierarchy = {};
+
+	std::vector<v3> positions(_vertexCount);
+
+	for (size_t vertex = 0; vertex < _vertexCount; ++vertex)
+	{
+		positions[vertex] = v3(_pVertices[vertex].position[0], _pVertices[vertex].position[1], _pVertices[vertex].position[2]);
+	}
+
+	std::vector<u32> positionRemap(_vertexCount);
+	meshopt_generateVertexRemap(positionRemap.data(), nullptr, _vertexCount, positions.data(), _vertexCount, sizeof(v3));
+
+	// Triangles of every cluster which still has to be grouped, indexed by cluster.
+	std::vector<std::vector<u32>> clusterIndices;
+	std::vector<u32> pendingClusters;
+
+	for (u32 meshletIndex = 0; meshletIndex < _meshletCount; ++meshletIndex)
+	{
+		const Meshlet& rMeshlet = _pMeshlets[meshletIndex];
+
+		Cluster cluster{};
+		cluster.center[0] = cluster.parentCenter[0] = rMeshlet.center[0];
+		cluster.center[1] = cluster.parentCenter[1] = rMeshlet.center[1];
+		cluster.center[2] = cluster.parentCenter[2] = rMeshlet.center[2];
+		cluster.radius = cluster.parentRadius = rMeshlet.radius;
+		cluster.error = 0.0f;
+		cluster.parentError = FLT_MAX;
+		cluster.meshletIndex = meshletIndex;
+		cluster.level = 0u;
+
+		pendingClusters.push_back(u32(_rHierarchy.clusters.size()));
+		_rHierarchy.clusters.push_back(cluster);
+		clusterIndices.push_back(getMeshletIndices(rMeshlet, _pMeshletVertices, _pMeshletTriangles));
+	}
+
+	_rHierarchy.levelCount = 1u;
+
+	while (pendingClusters.size() > 1 && _rHierarchy.levelCount < kMaxClusterLevels)
+	{
+		std::vector<std::vector<u32>> groups = partitionClusters(pendingClusters, clusterIndices, positionRemap);
+		std::vector<ClusterGroupResult> results(groups.size());
+
+		jobs::parallelFor(u32(groups.size()), [&](u32 _groupIndex)
+			{
+				simplifyClusterGroup(results[_groupIndex], groups[_groupIndex], _rHierarchy,
+					clusterIndices, _pVertices, _coneWeight);
+			});
+
+		// Results are appended in group order, which keeps the hierarchy deterministic.
+		std::vector<u32> nextPendingClusters;
+
+		for (u32 groupIndex = 0; groupIndex < groups.size(); ++groupIndex)
+		{
+			ClusterGroupResult& rResult = results[groupIndex];
+
+			for (u32 clusterIndex : groups[groupIndex])
+			{
+				clusterIndices[clusterIndex] = {};
+
+				if (rResult.bSimplified)
+				{
+					Cluster& rCluster = _rHierarchy.clusters[clusterIndex];
+					rCluster.parentCenter[0] = rResult.bounds.x;
+					rCluster.parentCenter[1] = rResult.bounds.y;
+					rCluster.parentCenter[2] = rResult.bounds.z;
+					rCluster.parentRadius = rResult.bounds.w;
+					rCluster.parentError = rResult.error;
+				}
+			}
+
+			if (!rResult.bSimplified)
+			{
+				continue;
+			}
+
+			u32 meshletVerticesOffset = u32(_rHierarchy.meshletVertices.size());
+			u32 meshletTrianglesOffset = u32(_rHierarchy.meshletTriangles.size());
+
+			for (Meshlet& rMeshlet : rResult.meshlets)
+			{
+				clusterIndices.push_back(getMeshletIndices(rMeshlet, rResult.meshletVertices.data(), rResult.meshletTriangles.data()));
+
+				rMeshlet.vertexOffset += meshletVerticesOffset;
+				rMeshlet.triangleOffset += meshletTrianglesOffset;
+
+				Cluster cluster{};
+				cluster.center[0] = cluster.parentCenter[0] = rResult.bounds.x;
+				cluster.center[1] = cluster.parentCenter[1] = rResult.bounds.y;
+				cluster.center[2] = cluster.parentCenter[2] = rResult.bounds.z;
+				cluster.radius = cluster.parentRadius = rResult.bounds.w;
+				cluster.error = rResult.error;
+				cluster.parentError = FLT_MAX;
+				cluster.meshletIndex = _meshletCount + u32(_rHierarchy.meshlets.size());
+				cluster.level = _rHierarchy.levelCount;
+
+				nextPendingClusters.push_back(u32(_rHierarchy.clusters.size()));
+				_rHierarchy.clusters.push_back(cluster);
+				_rHierarchy.meshlets.push_back(rMeshlet);
+			}
+
+			_rHierarchy.meshletVertices.insert(_rHierarchy.meshletVertices.end(), rResult.meshletVertices.begin(), rResult.meshletVertices.end());
+			_rHierarchy.meshletTriangles.insert(_rHierarchy.meshletTriangles.end(), rResult.meshletTriangles.begin(), rResult.meshletTriangles.end());
+		}
+
+		if (nextPendingClusters.empty())
+		{
+			break;
+		}
+
+		pendingClusters = std::move(nextPendingClusters);
+		++_rHierarchy.levelCount;
+	}
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+// Continuous LOD cluster hierarchy. Neighbouring clusters are grouped with METIS graph partitioning,
+// every group is simplified with locked borders and split into new clusters, until a single root is left.
+// Error and bounds are monotonic, parents always have larger errors and bounds enclosing their children.
+
+struct ClusterHierarchy
+{
+	// Level 0 clusters index the source meshlets. Higher level clusters index the meshlets below,
+	// offset by the source meshlet count.
+	std::vector<Cluster> clusters;
+	std::vector<Meshlet> meshlets;
+	std::vector<u32> meshletVertices;
+	std::vector<u8> meshletTriangles;
+	u32 levelCount = 0u;
+};
+
+void buildClusterHierarchy(
+	ClusterHierarchy& _rHierarchy,
+	const Meshlet* _pMeshlets,
+	u32 _meshletCount,
+	const u32* _pMeshletVertices,
+	const u8* _pMeshletTriangles,
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	f32 _coneWeight);
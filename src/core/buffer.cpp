@@ -22,16 +22,17 @@ Buffer createBuffer(
 	allocationCreateInfo.usage = VMA_MEMORY_USAGE_AUTO;
 
 	// This enables only sequential writes into this memory,
-	// so if we end up needing random access, use VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT.
-	allocationCreateInfo.flags = _desc.access == MemoryAccess::Host ?
-		VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT : 0u;
+	// readback memory gets random access instead, since it's read on the CPU.
+	allocationCreateInfo.flags =
+		_desc.access == MemoryAccess::Host ? VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT :
+		_desc.access == MemoryAccess::Readback ? VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT : 0u;
 
 	Buffer buffer = { .byteSize = _desc.byteSize };
 
 	VK_CALL(vmaCreateBuffer(_rDevice.allocator, &bufferCreateInfo,
 		&allocationCreateInfo, &buffer.resource, &buffer.allocation, nullptr));
 
-	if (_desc.access == MemoryAccess::Host)
+	if (_desc.access != MemoryAccess::Device)
 	{
 		// Persistently mapped memory, which should be faster on NVidia.
 		vmaMapMemory(_rDevice.allocator, buffer.allocation, &buffer.pMappedData);
@@ -123,3 +124,39 @@ void fillBuffer(
 		VK_ACCESS_TRANSFER_WRITE_BIT, _dstAccessMask,
 		VK_PIPELINE_STAGE_TRANSFER_BIT, _dstStageMask);
 }
+
+void updateBuffer(
+	VkCommandBuffer _commandBuffer,
+	Device& _rDevice,
+	Buffer& _rBuffer,
+	u32 _byteSize,
+	const void* _pData,
+	VkAccessFlags _srcAccessMask,
+	VkAccessFlags _dstAccessMask,
+	VkPipelineStageFlags _srcStageMask,
+	VkPipelineStageFlags _dstStageMask)
+{
+	assert(_byteSize <= _rBuffer.byteSize);
+	assert(_byteSize <= 65536u && _byteSize % 4u == 0u);
+
+	bufferBarrier(_commandBuffer, _rDevice, _rBuffer,
+		_srcAccessMask, VK_ACCESS_TRANSFER_WRITE_BIT,
+		_srcStageMask, VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+	vkCmdUpdateBuffer(_commandBuffer, _rBuffer.resource, 0u, _byteSize, _pData);
+
+	bufferBarrier(_commandBuffer, _rDevice, _rBuffer,
+		VK_ACCESS_TRANSFER_WRITE_BIT, _dstAccessMask,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, _dstStageMask);
+}
+
+void copyBuffer(
+	VkCommandBuffer _commandBuffer,
+	Buffer& _rSrcBuffer,
+	Buffer& _rDstBuffer)
+{
+	assert(_rSrcBuffer.byteSize <= _rDstBuffer.byteSize);
+
+	VkBufferCopy copyRegion = { .size = _rSrcBuffer.byteSize };
+	vkCmdCopyBuffer(_commandBuffer, _rSrcBuffer.resource, _rDstBuffer.resource, 1, &copyRegion);
+}
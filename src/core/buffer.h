@@ -12,6 +12,7 @@ enum class MemoryAccess : u8
 {
 	Host,
 	Device,
+	Readback,
 };
 
 struct BufferDesc
@@ -48,3 +49,20 @@ void fillBuffer(
 	VkAccessFlags _dstAccessMask,
 	VkPipelineStageFlags _srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
 	VkPipelineStageFlags _dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+// Inline update of the start of the buffer, which is limited to 64KB by Vulkan.
+void updateBuffer(
+	VkCommandBuffer _commandBuffer,
+	Device& _rDevice,
+	Buffer& _rBuffer,
+	u32 _byteSize,
+	const void* _pData,
+	VkAccessFlags _srcAccessMask,
+	VkAccessFlags _dstAccessMask,
+	VkPipelineStageFlags _srcStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+	VkPipelineStageFlags _dstStageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+
+void copyBuffer(
+	VkCommandBuffer _commandBuffer,
+	Buffer& _rSrcBuffer,
+	Buffer& _rDstBuffer);
@@ -259,6 +259,7 @@ static VkDevice createDevice(
 	VkPhysicalDeviceFeatures2 deviceFeatures2 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2 };
 	deviceFeatures2.features.pipelineStatisticsQuery = VK_TRUE;
 	deviceFeatures2.features.shaderInt16 = VK_TRUE;
+	deviceFeatures2.features.drawIndirectFirstInstance = VK_TRUE;
 
 	VkPhysicalDeviceVulkan11Features deviceFeatures11 = { VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_1_FEATURES };
 	deviceFeatures11.storageBuffer16BitAccess = VK_TRUE;
@@ -208,11 +208,13 @@ static VkPipeline createGraphicsPipeline(
 	VkDynamicState dynamicStates[] =
 	{
 		VK_DYNAMIC_STATE_VIEWPORT,
-		VK_DYNAMIC_STATE_SCISSOR
+		VK_DYNAMIC_STATE_SCISSOR,
+		VK_DYNAMIC_STATE_FRONT_FACE
 	};
 
+	// Front face is the last dynamic state, so it's left out simply by not counting it.
 	VkPipelineDynamicStateCreateInfo dynamicStateCreateInfo = { VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
-	dynamicStateCreateInfo.dynamicStateCount = ARRAY_SIZE(dynamicStates);
+	dynamicStateCreateInfo.dynamicStateCount = ARRAY_SIZE(dynamicStates) - (_desc.rasterization.bDynamicFrontFace ? 0u : 1u);
 	dynamicStateCreateInfo.pDynamicStates = dynamicStates;
 
 	std::vector<VkFormat> colorFormats;
@@ -14,6 +14,7 @@ struct RasterizationDesc
 {
 	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;         // Rasterization cull mode.
 	VkFrontFace frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;  // Front face orientation for culling.
+	bool bDynamicFrontFace = false;                           // Front face is set with vkCmdSetFrontFace before every draw instead.
 };
 
 struct DepthStencilDesc
@@ -1,61 +1,301 @@
 #include "core/device.h"
 #include "core/buffer.h"
 
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "utils.h"
 #include "draw.h"
 
+#include <float.h>
+#include <algorithm>
+#include <numeric>
+
+// Spreads the lower 10 bits of the value to every third bit.
+static u32 expandBits(
+	u32 _value)
+{
+	_value = (_value * 0x00010001u) & 0xFF0000FFu;
+	_value = (_value * 0x00000101u) & 0x0F00F00Fu;
+	_value = (_value * 0x00000011u) & 0xC30C30C3u;
+	_value = (_value * 0x00000005u) & 0x49249249u;
+
+	return _value;
+}
+
+// Position is given relative to the bounds of all positions, in the [0, 1] range.
+static u32 calculateMortonCode(
+	v3 _position)
+{
+	uv3 cell = uv3(glm::clamp(_position * 1024.0f, 0.0f, 1023.0f));
+	return (expandBits(cell.x) << 2) | (expandBits(cell.y) << 1) | expandBits(cell.z);
+}
+
+// Node sphere is centered in the box around its children, which is close to minimal for spatially sorted children.
+static InstanceNode mergeInstanceNodes(
+	const InstanceNode* _pNodes,
+	u32 _nodeCount)
+{
+	v3 boxMin = v3(FLT_MAX);
+	v3 boxMax = v3(-FLT_MAX);
+
+	for (u32 nodeIndex = 0; nodeIndex < _nodeCount; ++nodeIndex)
+	{
+		boxMin = glm::min(boxMin, _pNodes[nodeIndex].center - _pNodes[nodeIndex].radius);
+		boxMax = glm::max(boxMax, _pNodes[nodeIndex].center + _pNodes[nodeIndex].radius);
+	}
+
+	InstanceNode mergedNode = { .center = 0.5f * (boxMin + boxMax) };
+
+	for (u32 nodeIndex = 0; nodeIndex < _nodeCount; ++nodeIndex)
+	{
+		mergedNode.radius = glm::max(mergedNode.radius,
+			glm::distance(mergedNode.center, _pNodes[nodeIndex].center) + _pNodes[nodeIndex].radius);
+	}
+
+	return mergedNode;
+}
+
+// Model matrix is split into a translation, a rotation quaternion and column scales, see PerDrawData.
+static PerDrawData encodePerDrawData(
+	const m4& _model,
+	u32 _meshIndex)
+{
+	v3 scale = v3(glm::length(v3(_model[0])), glm::length(v3(_model[1])), glm::length(v3(_model[2])));
+	assert(scale.x > 0.0f && scale.y > 0.0f && scale.z > 0.0f);
+
+	// Quaternions only hold proper rotations, so mirroring moves into the scale.
+	if (glm::determinant(m3(_model)) < 0.0f)
+	{
+		scale.x = -scale.x;
+	}
+
+	glm::quat rotation = glm::normalize(glm::quat_cast(m3(
+		v3(_model[0]) / scale.x,
+		v3(_model[1]) / scale.y,
+		v3(_model[2]) / scale.z)));
+
+	return {
+		.position = v3(_model[3]),
+		.meshIndex = _meshIndex,
+		.rotation = uv2(
+			glm::packSnorm2x16(v2(rotation.x, rotation.y)),
+			glm::packSnorm2x16(v2(rotation.z, rotation.w))),
+		.scale = uv2(
+			glm::packHalf2x16(v2(scale.x, scale.y)),
+			glm::packHalf2x16(v2(scale.z, 0.0f))) };
+}
+
+// Matches decodeModel in shaders, so bounds are built from the transform that is actually drawn.
+static m4 decodeModel(
+	const PerDrawData& _rPerDrawData)
+{
+	v2 rotationXY = glm::unpackSnorm2x16(_rPerDrawData.rotation.x);
+	v2 rotationZW = glm::unpackSnorm2x16(_rPerDrawData.rotation.y);
+	m3 rotation = glm::mat3_cast(glm::normalize(glm::quat(rotationZW.y, rotationXY.x, rotationXY.y, rotationZW.x)));
+
+	v2 scaleXY = glm::unpackHalf2x16(_rPerDrawData.scale.x);
+	f32 scaleZ = glm::unpackHalf2x16(_rPerDrawData.scale.y).x;
+
+	return m4(
+		v4(rotation[0] * scaleXY.x, 0.0f),
+		v4(rotation[1] * scaleXY.y, 0.0f),
+		v4(rotation[2] * scaleZ, 0.0f),
+		v4(_rPerDrawData.position, 1.0f));
+}
+
 DrawBuffers createDrawBuffers(
 	Device& _rDevice,
-	u32 _meshCount,
+	const std::vector<u32>& _rSourceMeshOffsets,
+	const std::vector<u32>& _rSourceInstanceOffsets,
+	const std::vector<MeshInstance>& _rInstances,
+	const std::vector<Mesh>& _rMeshes,
 	u32 _maxDrawCount,
 	u32 _spawnCubeSize)
 {
 	EASY_BLOCK("InitializeDraws");
-	u32 sum = 0;
-	std::vector<PerDrawData> perDrawDataVector(_maxDrawCount);
-	for (u32 drawIndex = 0; drawIndex < _maxDrawCount; ++drawIndex)
+
+	u32 sourceCount = u32(_rSourceMeshOffsets.size() - 1);
+	std::vector<PerDrawData> perDrawDataVector;
+	perDrawDataVector.reserve(_maxDrawCount);
+
+	// Sources with instances are scenes, which are drawn once per instance, with the instance transform.
+	std::vector<u32> spawnedSourceIndices;
+	for (u32 sourceIndex = 0u; sourceIndex < sourceCount; ++sourceIndex)
 	{
-		PerDrawData perDrawData = { .meshIndex = drawIndex % _meshCount };
+		if (_rSourceInstanceOffsets[sourceIndex] == _rSourceInstanceOffsets[sourceIndex + 1])
+		{
+			spawnedSourceIndices.push_back(sourceIndex);
+			continue;
+		}
+
+		for (u32 instanceIndex = _rSourceInstanceOffsets[sourceIndex];
+			instanceIndex < _rSourceInstanceOffsets[sourceIndex + 1]; ++instanceIndex)
+		{
+			const MeshInstance& rInstance = _rInstances[instanceIndex];
+
+			m4 model;
+			memcpy(&model, rInstance.transform, sizeof(model));
 
-		u32 ts[] = { /*kitten*/4952 , /*dragon*/146325 , /*bunny*/24126 };
+			for (u32 meshIndex = rInstance.meshOffset;
+				meshIndex < rInstance.meshOffset + rInstance.meshCount && perDrawDataVector.size() < _maxDrawCount; ++meshIndex)
+			{
+				perDrawDataVector.push_back(encodePerDrawData(model, meshIndex));
+			}
+		}
+	}
 
-		sum += ts[perDrawData.meshIndex];
+	if (perDrawDataVector.size() == _maxDrawCount && !spawnedSourceIndices.empty())
+	{
+		printf("Scene instances use all of %u draws, no meshes are spawned.\n", _maxDrawCount);
+	}
+
+	// Remaining draws are filled with randomly spawned instances of the other sources.
+	for (u32 instanceIndex = 0u; !spawnedSourceIndices.empty() && perDrawDataVector.size() < _maxDrawCount; ++instanceIndex)
+	{
+		u32 sourceIndex = spawnedSourceIndices[instanceIndex % spawnedSourceIndices.size()];
 
 		auto randomFloat = []()
 		{
 			return f32(rand()) / RAND_MAX;
 		};
 
-		// TODO-MILKRU: Multiply meshlet/mesh bounding spheres by scale.
-		perDrawData.model = glm::scale(m4(1.0f), v3(1.0f));
+		m4 model = glm::scale(m4(1.0f), v3(1.0f));
 
-		perDrawData.model = glm::rotate(perDrawData.model,
+		model = glm::rotate(model,
 			glm::radians(360.0f * randomFloat()), v3(0.0, 1.0, 0.0));
 
-		perDrawData.model = glm::translate(perDrawData.model, {
+		model = glm::translate(model, {
 			_spawnCubeSize * (randomFloat() - 0.5f),
 			_spawnCubeSize * (randomFloat() - 0.5f),
 			_spawnCubeSize * (randomFloat() - 0.5f) });
 
-		perDrawDataVector[drawIndex] = perDrawData;
+		for (u32 meshIndex = _rSourceMeshOffsets[sourceIndex];
+			meshIndex < _rSourceMeshOffsets[sourceIndex + 1] && perDrawDataVector.size() < _maxDrawCount; ++meshIndex)
+		{
+			perDrawDataVector.push_back(encodePerDrawData(model, meshIndex));
+		}
+	}
+
+	u32 drawCount = u32(perDrawDataVector.size());
+	assert(drawCount > 0u);
+
+	// Draws are sorted along a Morton curve of their world space bounds, so consecutive draws make compact leaf nodes.
+	// Bounds are cached for culling too, which then reads 16 bytes per draw instead of its transform and mesh.
+	// Transforms never change after creation, so neither do the bounds.
+	std::vector<InstanceNode> drawSpheres(drawCount);
+	v3 centerMin = v3(FLT_MAX);
+	v3 centerMax = v3(-FLT_MAX);
+
+	for (u32 drawIndex = 0; drawIndex < drawCount; ++drawIndex)
+	{
+		const PerDrawData& rPerDrawData = perDrawDataVector[drawIndex];
+		const Mesh& rMesh = _rMeshes[rPerDrawData.meshIndex];
+		m4 model = decodeModel(rPerDrawData);
+
+		f32 modelScale = glm::max(glm::max(
+			glm::length(v3(model[0])),
+			glm::length(v3(model[1]))),
+			glm::length(v3(model[2])));
+
+		drawSpheres[drawIndex] = {
+			.center = v3(model * v4(rMesh.center[0], rMesh.center[1], rMesh.center[2], 1.0f)),
+			.radius = rMesh.radius * modelScale };
+
+		centerMin = glm::min(centerMin, drawSpheres[drawIndex].center);
+		centerMax = glm::max(centerMax, drawSpheres[drawIndex].center);
+	}
+
+	std::vector<u32> mortonCodes(drawCount);
+	for (u32 drawIndex = 0; drawIndex < drawCount; ++drawIndex)
+	{
+		mortonCodes[drawIndex] = calculateMortonCode(
+			(drawSpheres[drawIndex].center - centerMin) / glm::max(centerMax - centerMin, v3(FLT_MIN)));
+	}
+
+	std::vector<u32> drawOrder(drawCount);
+	std::iota(drawOrder.begin(), drawOrder.end(), 0u);
+	std::sort(drawOrder.begin(), drawOrder.end(), [&](u32 _left, u32 _right)
+		{
+			return mortonCodes[_left] < mortonCodes[_right];
+		});
+
+	std::vector<PerDrawData> sortedPerDrawDataVector(drawCount);
+	std::vector<InstanceNode> sortedDrawSpheres(drawCount);
+
+	for (u32 drawIndex = 0; drawIndex < drawCount; ++drawIndex)
+	{
+		sortedPerDrawDataVector[drawIndex] = perDrawDataVector[drawOrder[drawIndex]];
+		sortedDrawSpheres[drawIndex] = drawSpheres[drawOrder[drawIndex]];
+	}
+
+	perDrawDataVector = std::move(sortedPerDrawDataVector);
+
+	// Two level hierarchy, leaf nodes over draws and top nodes over leaf nodes, is enough for millions of draws,
+	// since every top node covers a workgroup worth of leaf nodes.
+	u32 leafNodeCount = divideRoundingUp(drawCount, kInstanceNodeChildCount);
+	u32 topNodeCount = divideRoundingUp(leafNodeCount, kInstanceNodeChildCount);
+	std::vector<InstanceNode> instanceNodes(leafNodeCount + topNodeCount);
+
+	for (u32 leafNodeIndex = 0; leafNodeIndex < leafNodeCount; ++leafNodeIndex)
+	{
+		u32 firstDraw = leafNodeIndex * kInstanceNodeChildCount;
+		instanceNodes[leafNodeIndex] = mergeInstanceNodes(&sortedDrawSpheres[firstDraw],
+			glm::min(drawCount - firstDraw, u32(kInstanceNodeChildCount)));
+	}
+
+	for (u32 topNodeIndex = 0; topNodeIndex < topNodeCount; ++topNodeIndex)
+	{
+		u32 firstLeafNode = topNodeIndex * kInstanceNodeChildCount;
+		instanceNodes[leafNodeCount + topNodeIndex] = mergeInstanceNodes(&instanceNodes[firstLeafNode],
+			glm::min(leafNodeCount - firstLeafNode, u32(kInstanceNodeChildCount)));
 	}
-	printf("%d\n", sum);
+
 	DrawBuffers drawBuffers = {
 		.drawsBuffer = createBuffer(_rDevice, {
 			.byteSize = sizeof(PerDrawData) * perDrawDataVector.size(),
 			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
 			.pContents = perDrawDataVector.data() }),
 
+		.drawBoundsBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(InstanceNode) * sortedDrawSpheres.size(),
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			.pContents = sortedDrawSpheres.data() }),
+
 		.drawCommandsBuffer = createBuffer(_rDevice, {
-			.byteSize = sizeof(DrawCommand) * _maxDrawCount,
+			.byteSize = sizeof(DrawCommand) * kDrawBatchCount * drawCount,
 			.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT }),
 
 		.drawCountBuffer = createBuffer(_rDevice, {
-			.byteSize = sizeof(u32),
+			.byteSize = sizeof(u32) * kDrawBatchCount,
 			.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
 
 		.visibilityBuffer = createBuffer(_rDevice, {
 			.byteSize = sizeof(i32) * perDrawDataVector.size(),
-			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }) };
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
+
+		.impostorDrawsBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(ImpostorDrawCommand) + sizeof(u32) * drawCount,
+			.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
+
+		.instanceNodesBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(InstanceNode) * instanceNodes.size(),
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			.pContents = instanceNodes.data() }),
+
+		.instanceNodeVisibilityBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(u32) * leafNodeCount,
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
+
+		.visibleInstanceNodesBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(VkDispatchIndirectCommand) + sizeof(u32) * leafNodeCount,
+			.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
+
+		.pendingDrawsBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(PendingDrawsCommand) + sizeof(u32) * drawCount,
+			.usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
+
+		.drawCount = drawCount,
+		.topInstanceNodeCount = topNodeCount };
 
 	immediateSubmit(_rDevice, [&](VkCommandBuffer _commandBuffer)
 		{
@@ -64,6 +304,9 @@ DrawBuffers createDrawBuffers(
 
 			fillBuffer(_commandBuffer, _rDevice, drawBuffers.visibilityBuffer, 0u,
 				VK_ACCESS_NONE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
+
+			fillBuffer(_commandBuffer, _rDevice, drawBuffers.instanceNodeVisibilityBuffer, 0u,
+				VK_ACCESS_NONE, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT);
 		});
 
 	return drawBuffers;
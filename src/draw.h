@@ -1,11 +1,17 @@
 #pragma once
 
+// Instance transform is a translation, a unit quaternion packed to snorm16 and per axis scales packed to half floats,
+// which keeps every draw at 32 bytes. Shear isn't representable, and mirroring is folded into the first axis scale.
 struct alignas(16) PerDrawData
 {
-	m4 model{};
+	v3 position{};
 	u32 meshIndex = 0u;
+	uv2 rotation{};
+	uv2 scale{};
 };
 
+static_assert(sizeof(PerDrawData) == 32);
+
 struct DrawCommand
 {
 	u32 indexCount = 0u;
@@ -21,16 +27,57 @@ struct DrawCommand
 	u32 lodIndex = 0u;
 };
 
+// Bounding sphere of an instance hierarchy node. Draws are sorted along a Morton curve, so every leaf node bounds
+// kInstanceNodeChildCount consecutive draws, and every top node bounds as many consecutive leaf nodes.
+struct InstanceNode
+{
+	v3 center{};
+	f32 radius = 0.0f;
+};
+
+// Single instanced draw of every impostor quad, followed by the draw index of every instance in the impostors buffer.
+struct ImpostorDrawCommand
+{
+	u32 vertexCount = 6u;
+	u32 instanceCount = 0u;
+	u32 firstVertex = 0u;
+	u32 firstInstance = 0u;
+};
+
+// Second draw generation pass is dispatched over draws left pending by the prepass and the second instance node pass,
+// whose draw indices follow it. Lowest bit of every one of them is set on draws which the prepass already drew.
+struct PendingDrawsCommand
+{
+	u32 groupCountX = 0u;
+	u32 groupCountY = 1u;
+	u32 groupCountZ = 1u;
+	u32 drawCount = 0u;
+};
+
 struct DrawBuffers
 {
 	Buffer drawsBuffer{};
-	Buffer drawCommandsBuffer{};
-	Buffer drawCountBuffer{};
+	Buffer drawBoundsBuffer{};             // World space bounding sphere of every draw, with its model scale applied.
+	Buffer drawCommandsBuffer{};           // Max draw count commands for every draw batch.
+	Buffer drawCountBuffer{};              // Draw count of every draw batch.
 	Buffer visibilityBuffer{};
+	Buffer impostorDrawsBuffer{};          // Impostor draw command, followed by room for every draw index.
+	Buffer instanceNodesBuffer{};          // Leaf nodes, followed by top nodes.
+	Buffer instanceNodeVisibilityBuffer{}; // Leaf node visibility, written by the second culling pass.
+	Buffer visibleInstanceNodesBuffer{};   // Prepass draw generation dispatch command, followed by room for every leaf node.
+	Buffer pendingDrawsBuffer{};           // Pending draws command, followed by room for every draw index.
+	u32 drawCount = 0u;                    // Draws which every draw batch has room for.
+	u32 topInstanceNodeCount = 0u;
 };
 
+// Every spawned instance draws all meshes of its source file with the same transform,
+// so spatial chunks of a mesh are culled as separate draws. Scene sources are drawn once per their instance instead,
+// and only the draws which are left after them are spawned. Instance hierarchy is built over their world space bounds.
 DrawBuffers createDrawBuffers(
 	Device& _rDevice,
-	u32 _meshCount,
+	const std::vector<u32>& _rSourceMeshOffsets,
+	const std::vector<u32>& _rSourceInstanceOffsets,
+	const std::vector<MeshInstance>& _rInstances,
+	const std::vector<Mesh>& _rMeshes,
 	u32 _maxDrawCount,
 	u32 _spawnCubeSize);
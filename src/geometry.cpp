@@ -3,267 +3,574 @@
 
 #include "shaders/shader_constants.h"
 #include "geometry.h"
+#include "utils.h"
+#include "geometry_cache.h"
+#include "mesh_import.h"
+#include "job_system.h"
 
-#include <fast_obj.h>
-#include <meshoptimizer.h>
+#include <string.h>
+#include <stdlib.h>
+#include <unordered_map>
 
-struct RawVertex
+struct MeshGeometrySource
 {
-	f32 position[3];
-	f32 normal[3];
-	f32 texCoord[2];
+	const char* pFilePath = nullptr;
+	MeshProcessingDesc processingDesc{};
+	GeometryCache cache{};     // Valid cache file, its streams are read straight into staging memory.
+	Geometry geometry{};       // Imported geometry, when there was no valid cache file.
+	GeometryCounts counts{};
+	u32 shortIndexCount = 0u;  // Part of counts.indexCount which goes into the 16 bit index pool.
+	u64 hash = 0ull;           // Hash of every processed stream, equal for sources with identical geometry.
+	std::vector<Mesh> meshes;  // Meshes and instances patched with merged offsets, which sources aliasing this one copy.
+	std::vector<MeshInstance> instances;
 };
 
-// TODO-MILKRU: Implement a more conservative way of calculating bounding sphere?
-static v4 calculateMeshBounds(
-	std::vector<RawVertex>& _rVertices)
+static u32 getShortIndexCount(
+	const std::vector<Mesh>& _rMeshes)
 {
-	v4 meshBounds(0.0f);
-	for (RawVertex& vertex : _rVertices)
-	{
-		meshBounds += v4(vertex.position[0], vertex.position[1], vertex.position[2], 0.0f);
-	}
-	meshBounds /= f32(_rVertices.size());
+	u32 shortIndexCount = 0u;
 
-	for (RawVertex& vertex : _rVertices)
+	for (const Mesh& rMesh : _rMeshes)
 	{
-		meshBounds.w = glm::max(meshBounds.w, glm::distance(v3(meshBounds),
-			v3(vertex.position[0], vertex.position[1], vertex.position[2])));
+		for (u32 lodIndex = 0; lodIndex < rMesh.lodCount; ++lodIndex)
+		{
+			shortIndexCount += rMesh.lods[lodIndex].bShortIndices ? rMesh.lods[lodIndex].indexCount : 0u;
+		}
 	}
 
-	return meshBounds;
+	return shortIndexCount;
 }
 
-static Vertex quantizeVertex(
-	RawVertex& _rRawVertex)
+// Index pools are only known once the meshes are read, which is cheap, since the mesh stream is never compressed.
+static u32 getShortIndexCount(
+	GeometryCache& _rCache)
 {
-	Vertex vertex{};
-
-	// TODO-MILKRU: To snorm.
-	vertex.position[0] = meshopt_quantizeHalf(_rRawVertex.position[0]);
-	vertex.position[1] = meshopt_quantizeHalf(_rRawVertex.position[1]);
-	vertex.position[2] = meshopt_quantizeHalf(_rRawVertex.position[2]);
+	std::vector<Mesh> meshes(_rCache.counts.meshCount);
+	bool bRead = readGeometryCache(_rCache, { .pMeshes = meshes.data() });
+	assert(bRead && "Raw streams are validated when the cache is opened!");
 
-	vertex.normal[0] = u8(meshopt_quantizeUnorm(_rRawVertex.normal[0], 8));
-	vertex.normal[1] = u8(meshopt_quantizeUnorm(_rRawVertex.normal[1], 8));
-	vertex.normal[2] = u8(meshopt_quantizeUnorm(_rRawVertex.normal[2], 8));
-
-	// TODO-MILKRU: To unorm.
-	vertex.texCoord[0] = meshopt_quantizeHalf(_rRawVertex.texCoord[0]);
-	vertex.texCoord[1] = meshopt_quantizeHalf(_rRawVertex.texCoord[1]);
-
-	return vertex;
+	return getShortIndexCount(meshes);
 }
 
-static Meshlet buildMeshlet(
-	meshopt_Meshlet _meshlet,
-	meshopt_Bounds _bounds)
+static GeometryCounts getGeometryCounts(
+	Geometry& _rGeometry)
 {
-	Meshlet meshlet{};
-
-	meshlet.vertexOffset = _meshlet.vertex_offset;
-	meshlet.triangleOffset = _meshlet.triangle_offset;
-	meshlet.vertexCount = _meshlet.vertex_count;
-	meshlet.triangleCount = _meshlet.triangle_count;
-	
-	meshlet.center[0] = _bounds.center[0];
-	meshlet.center[1] = _bounds.center[1];
-	meshlet.center[2] = _bounds.center[2];
-	meshlet.radius = _bounds.radius;
-
-	meshlet.coneAxis[0] = _bounds.cone_axis_s8[0];
-	meshlet.coneAxis[1] = _bounds.cone_axis_s8[1];
-	meshlet.coneAxis[2] = _bounds.cone_axis_s8[2];
-	meshlet.coneCutoff = _bounds.cone_cutoff_s8;
-
-	return meshlet;
+	return {
+		.meshletCount = u32(_rGeometry.meshlets.size()),
+		.meshletVertexCount = u32(_rGeometry.meshletVertices.size()),
+		.meshletTriangleCount = u32(_rGeometry.meshletTriangles.size()),
+		.clusterCount = u32(_rGeometry.clusters.size()),
+		.vertexCount = u32(_rGeometry.vertices.size()),
+		.indexCount = u32(_rGeometry.indices.size()),
+		.meshCount = u32(_rGeometry.meshes.size()),
+		.pageCount = u32(_rGeometry.pages.size()),
+		.pageDataByteCount = u32(_rGeometry.pageData.size()),
+		.instanceCount = u32(_rGeometry.instances.size()) };
 }
 
-static void loadMesh(
-	Geometry& _rGeometry,
+static void openMeshGeometry(
+	MeshGeometrySource& _rSource,
 	const char* _pFilePath,
-	bool _bMeshShadingSupported)
+	MeshProcessingDesc _processingDesc)
 {
-	fastObjMesh* objMesh = fast_obj_read(_pFilePath);
-	assert(objMesh);
+	EASY_BLOCK("OpenMesh");
+
+	u32 processingHash = calculateProcessingHash(_processingDesc);
 
-	std::vector<RawVertex> vertices;
-	vertices.reserve(objMesh->index_count);
+	_rSource.pFilePath = _pFilePath;
+	_rSource.processingDesc = _processingDesc;
 
-	for (u32 i = 0; i < objMesh->index_count; ++i)
+	if (isGeometryCachePath(_pFilePath))
 	{
-		fastObjIndex vertexIndex = objMesh->indices[i];
+		bool bOpened = tryOpenGeometryCache(_pFilePath, nullptr, processingHash, _rSource.cache);
+		assert(bOpened && "Baked geometry layout is out of date, bake it again!");
 
-		RawVertex vertex{};
+		_rSource.counts = _rSource.cache.counts;
+		_rSource.shortIndexCount = getShortIndexCount(_rSource.cache);
+		_rSource.hash = calculateGeometryCacheHash(_rSource.cache);
+		return;
+	}
 
-		vertex.position[0] = objMesh->positions[3 * size_t(vertexIndex.p) + 0];
-		vertex.position[1] = objMesh->positions[3 * size_t(vertexIndex.p) + 1];
-		vertex.position[2] = objMesh->positions[3 * size_t(vertexIndex.p) + 2];
+	std::string cachePath = getGeometryCachePath(_pFilePath);
 
-		// TODO-MILKRU: We can calculate normals from depth buffer after first geometry phase.
-		// See Wicked engine article about this.
-		vertex.normal[0] = 0.5f + 0.5f * objMesh->normals[3 * size_t(vertexIndex.n) + 0];
-		vertex.normal[1] = 0.5f + 0.5f * objMesh->normals[3 * size_t(vertexIndex.n) + 1];
-		vertex.normal[2] = 0.5f + 0.5f * objMesh->normals[3 * size_t(vertexIndex.n) + 2];
+	if (tryOpenGeometryCache(cachePath.c_str(), _pFilePath, processingHash, _rSource.cache))
+	{
+		_rSource.counts = _rSource.cache.counts;
+		_rSource.shortIndexCount = getShortIndexCount(_rSource.cache);
+		_rSource.hash = calculateGeometryCacheHash(_rSource.cache);
+		return;
+	}
 
-		vertex.texCoord[0] = objMesh->texcoords[2 * size_t(vertexIndex.t) + 0];
-		vertex.texCoord[1] = objMesh->texcoords[2 * size_t(vertexIndex.t) + 1];
+	importMesh(_rSource.geometry, _pFilePath, _processingDesc);
+	_rSource.counts = getGeometryCounts(_rSource.geometry);
+	_rSource.shortIndexCount = getShortIndexCount(_rSource.geometry.meshes);
+	_rSource.hash = calculateGeometryHash(_rSource.geometry);
 
-		vertices.push_back(vertex);
+	if (!saveGeometryCache(cachePath.c_str(), _pFilePath, processingHash, _rSource.geometry))
+	{
+		printf("Failed to write geometry cache %s.\n", cachePath.c_str());
 	}
+}
 
-	// TODO-MILKRU: All mesh preprocessing can be done offline in CMake for example.
+// Encoded cache streams are only validated by decoding them, which happens once staging memory is already sized
+// for the cache counts. Header hash guards the counts, and processing is deterministic, so the source imports into
+// the same counts again. Anything else would write past the staging memory, so it stops right here.
+static void reimportMeshGeometry(
+	MeshGeometrySource& _rSource)
+{
+	EASY_BLOCK("ReimportMesh");
 
-	std::vector<u32> remapTable(objMesh->index_count);
-	size_t vertexCount = meshopt_generateVertexRemap(remapTable.data(), nullptr, objMesh->index_count,
-		vertices.data(), vertices.size(), sizeof(RawVertex));
+	if (isGeometryCachePath(_rSource.pFilePath))
+	{
+		fprintf(stderr, "Baked geometry %s is corrupt, bake it again.\n", _rSource.pFilePath);
+		abort();
+	}
 
-	vertices.resize(vertexCount);
-	std::vector<u32> indices(objMesh->index_count);
+	printf("Geometry cache of %s is corrupt, importing it again.\n", _rSource.pFilePath);
+	importMesh(_rSource.geometry, _rSource.pFilePath, _rSource.processingDesc);
 
-	meshopt_remapVertexBuffer(vertices.data(), vertices.data(), indices.size(), sizeof(RawVertex), remapTable.data());
-	meshopt_remapIndexBuffer(indices.data(), nullptr, indices.size(), remapTable.data());
+	GeometryCounts counts = getGeometryCounts(_rSource.geometry);
+	if (memcmp(&counts, &_rSource.counts, sizeof(GeometryCounts)) != 0 ||
+		getShortIndexCount(_rSource.geometry.meshes) != _rSource.shortIndexCount)
+	{
+		fprintf(stderr, "Imported geometry of %s doesn't match its corrupt cache.\n", _rSource.pFilePath);
+		abort();
+	}
 
-	meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), vertices.size());
-	meshopt_optimizeOverdraw(indices.data(), indices.data(), indices.size(), &vertices[0].position[0], vertices.size(), sizeof(RawVertex), /*threshold*/ 1.01f);
-	meshopt_optimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(), vertices.size(), sizeof(RawVertex));
+	std::string cachePath = getGeometryCachePath(_rSource.pFilePath);
+	if (!saveGeometryCache(cachePath.c_str(), _rSource.pFilePath, calculateProcessingHash(_rSource.processingDesc), _rSource.geometry))
+	{
+		printf("Failed to write geometry cache %s.\n", cachePath.c_str());
+	}
+}
 
-	v4 meshBounds = calculateMeshBounds(vertices);
+template<typename T>
+static T* offsetStream(
+	T* _pStream,
+	u32 _offset)
+{
+	return _pStream ? _pStream + _offset : nullptr;
+}
 
-	Mesh mesh = {};
-	mesh.center[0] = meshBounds.x;
-	mesh.center[1] = meshBounds.y;
-	mesh.center[2] = meshBounds.z;
-	mesh.radius = meshBounds.w;
+template<typename T>
+static void copyStream(
+	T* _pDestination,
+	std::vector<T>& _rSource)
+{
+	if (_pDestination && !_rSource.empty())
+	{
+		memcpy(_pDestination, _rSource.data(), sizeof(T) * _rSource.size());
+	}
+}
+
+// Writes a single mesh into the merged streams at the given offsets. Index offset only counts 32 bit indices,
+// while indices of LODs with bShortIndices set are narrowed into the 16 bit pool at the short index offset.
+static void writeMeshGeometry(
+	MeshGeometrySource& _rSource,
+	GeometryCounts _offsets,
+	u32 _shortIndexOffset,
+	GeometryStreamPointers _streams,
+	u16* _pShortIndices)
+{
+	EASY_BLOCK("WriteMesh");
+
+	GeometryStreamPointers destination = {
+		.pMeshletVertices = offsetStream(_streams.pMeshletVertices, _offsets.meshletVertexCount),
+		.pMeshletTriangles = offsetStream(_streams.pMeshletTriangles, _offsets.meshletTriangleCount),
+		.pClusters = offsetStream(_streams.pClusters, _offsets.clusterCount),
+		.pVertices = offsetStream(_streams.pVertices, _offsets.vertexCount) };
 
-	mesh.vertexOffset = u32(_rGeometry.vertices.size());
-	_rGeometry.vertices.reserve(_rGeometry.vertices.size() + vertices.size());
+	// Meshlets, clusters, indices and meshes get patched with merged offsets, or split into index pools.
+	// They go through regular memory first, since staging memory is write combined and shouldn't be read from.
+	std::vector<Meshlet> meshlets;
+	std::vector<Cluster> clusters;
+	std::vector<u32> indices;
+	std::vector<Mesh> meshes;
+	std::vector<MeshInstance> instances;
 
-	for (RawVertex& rVertex : vertices)
+	bool bImported = _rSource.cache.file.pData == nullptr;
+
+	if (!bImported)
 	{
-		_rGeometry.vertices.push_back(quantizeVertex(rVertex));
+		meshlets.resize(_streams.pMeshlets ? _rSource.counts.meshletCount : 0u);
+		clusters.resize(_streams.pClusters ? _rSource.counts.clusterCount : 0u);
+		indices.resize(_rSource.counts.indexCount);
+		meshes.resize(_rSource.counts.meshCount);
+		instances.resize(_rSource.counts.instanceCount);
+
+		destination.pMeshlets = _streams.pMeshlets ? meshlets.data() : nullptr;
+		destination.pClusters = _streams.pClusters ? clusters.data() : nullptr;
+		destination.pIndices = indices.data();
+		destination.pMeshes = meshes.data();
+		destination.pInstances = instances.data();
+
+		bool bRead = readGeometryCache(_rSource.cache, destination);
+		closeGeometryCache(_rSource.cache);
+
+		if (!bRead)
+		{
+			reimportMeshGeometry(_rSource);
+			bImported = true;
+		}
 	}
 
-	mesh.lodCount = 0;
-
-	for (u32 lodIndex = 0u; lodIndex < kMaxMeshLods; ++lodIndex)
+	if (bImported)
 	{
-		mesh.lods[lodIndex].firstIndex = u32(_rGeometry.indices.size());
-		mesh.lods[lodIndex].indexCount = u32(indices.size());
-		_rGeometry.indices.insert(_rGeometry.indices.end(), indices.begin(), indices.end());
+		Geometry& rGeometry = _rSource.geometry;
 
-		if (_bMeshShadingSupported)
+		copyStream(destination.pMeshletVertices, rGeometry.meshletVertices);
+		copyStream(destination.pMeshletTriangles, rGeometry.meshletTriangles);
+		copyStream(destination.pVertices, rGeometry.vertices);
+
+		if (_streams.pMeshlets)
 		{
-			size_t maxMeshlets = meshopt_buildMeshletsBound(indices.size(), kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet);
-			std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
-			std::vector<u32> meshletVertices(maxMeshlets * kMaxVerticesPerMeshlet);
-			std::vector<u8> meshletTriangles(maxMeshlets * kMaxTrianglesPerMeshlet * 3);
+			meshlets = std::move(rGeometry.meshlets);
+		}
 
-			// TODO-MILKRU: After per-meshlet frustum/occlusion culling gets implemented, try playing around with cone_weight. You might get better performance.
-			size_t meshletCount = meshopt_buildMeshlets(meshlets.data(), meshletVertices.data(), meshletTriangles.data(), indices.data(), indices.size(),
-				&vertices[0].position[0], vertices.size(), sizeof(RawVertex), kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet, /*cone_weight*/ 0.7f);
+		if (_streams.pClusters)
+		{
+			clusters = std::move(rGeometry.clusters);
+		}
 
-			meshopt_Meshlet& rLastMeshlet = meshlets[meshletCount - 1];
+		indices = std::move(rGeometry.indices);
+		meshes = std::move(rGeometry.meshes);
+		instances = std::move(rGeometry.instances);
+		_rSource.geometry = {};
+	}
 
-			meshletVertices.resize(rLastMeshlet.vertex_offset + size_t(rLastMeshlet.vertex_count));
-			meshletTriangles.resize(rLastMeshlet.triangle_offset + ((size_t(rLastMeshlet.triangle_count) * 3 + 3) & ~3));
-			meshlets.resize(meshletCount);
+	for (Meshlet& rMeshlet : meshlets)
+	{
+		rMeshlet.vertexOffset += _offsets.meshletVertexCount;
+		rMeshlet.triangleOffset += _offsets.meshletTriangleCount;
+	}
+
+	for (Cluster& rCluster : clusters)
+	{
+		rCluster.meshletIndex += _offsets.meshletCount;
+	}
 
-			mesh.lods[lodIndex].meshletOffset = _rGeometry.meshlets.size();
-			mesh.lods[lodIndex].meshletCount = meshletCount;
+	u32 indexOffset = _offsets.indexCount;
+	u32 shortIndexOffset = _shortIndexOffset;
 
-			u32 globalMeshletVerticesOffset = _rGeometry.meshletVertices.size();
-			u32 globalMeshletTrianglesOffset = _rGeometry.meshletTriangles.size();
+	for (Mesh& rMesh : meshes)
+	{
+		rMesh.vertexOffset += _offsets.vertexCount;
+		rMesh.clusterOffset += _offsets.clusterCount;
 
-			_rGeometry.meshletVertices.insert(_rGeometry.meshletVertices.end(), meshletVertices.begin(), meshletVertices.end());
-			_rGeometry.meshletTriangles.insert(_rGeometry.meshletTriangles.end(), meshletTriangles.begin(), meshletTriangles.end());
-			_rGeometry.meshlets.reserve(_rGeometry.meshlets.size() + meshletCount);
+		for (u32 lodIndex = 0; lodIndex < rMesh.lodCount; ++lodIndex)
+		{
+			MeshLod& rLod = rMesh.lods[lodIndex];
+			const u32* pLodIndices = &indices[rLod.firstIndex];
 
-			for (u32 meshletIndex = 0; meshletIndex < meshlets.size(); ++meshletIndex)
+			if (rLod.bShortIndices)
 			{
-				meshopt_Meshlet& rMeshlet = meshlets[meshletIndex];
-				meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshletVertices[rMeshlet.vertex_offset], &meshletTriangles[rMeshlet.triangle_offset],
-					rMeshlet.triangle_count, &vertices[0].position[0], vertices.size(), sizeof(RawVertex));
+				u16* pShortIndices = &_pShortIndices[shortIndexOffset];
 
-				rMeshlet.vertex_offset += globalMeshletVerticesOffset;
-				rMeshlet.triangle_offset += globalMeshletTrianglesOffset;
+				for (u32 index = 0; index < rLod.indexCount; ++index)
+				{
+					pShortIndices[index] = u16(pLodIndices[index]);
+				}
 
-				_rGeometry.meshlets.push_back(buildMeshlet(rMeshlet, bounds));
+				rLod.firstIndex = shortIndexOffset;
+				shortIndexOffset += rLod.indexCount;
 			}
-		}
+			else
+			{
+				memcpy(&_streams.pIndices[indexOffset], pLodIndices, sizeof(u32) * rLod.indexCount);
 
-		++mesh.lodCount;
+				rLod.firstIndex = indexOffset;
+				indexOffset += rLod.indexCount;
+			}
 
-		if (lodIndex >= kMaxMeshLods - 1)
-		{
-			break;
+			rLod.vertexOffset += _offsets.vertexCount;
+			rLod.meshletOffset += _offsets.meshletCount;
+			rLod.pageOffset += _offsets.pageCount;
 		}
+	}
 
-		f32 threshold = 0.6f;
-		size_t targetIndexCount = size_t(indices.size() * threshold);
-		f32 targetError = 1e-2f;
+	copyStream(offsetStream(_streams.pMeshlets, _offsets.meshletCount), meshlets);
+	copyStream(offsetStream(_streams.pClusters, _offsets.clusterCount), clusters);
+	for (MeshInstance& rInstance : instances)
+	{
+		rInstance.meshOffset += _offsets.meshCount;
+	}
 
-		size_t newIndexCount = meshopt_simplify(indices.data(), indices.data(), indices.size(),
-			&vertices[0].position[0], vertices.size(), sizeof(RawVertex), targetIndexCount, targetError);
+	copyStream(offsetStream(_streams.pMeshes, _offsets.meshCount), meshes);
+	copyStream(offsetStream(_streams.pInstances, _offsets.instanceCount), instances);
 
-		if (indices.size() == newIndexCount)
-		{
-			break;
-		}
+	_rSource.meshes = std::move(meshes);
+	_rSource.instances = std::move(instances);
+}
 
-		indices.resize(newIndexCount);
-		meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), vertices.size());
+static u64 getGeometryByteSize(
+	GeometryCounts _counts,
+	u32 _shortIndexCount,
+	bool _bMeshletsRequired)
+{
+	u64 byteSize = sizeof(Vertex) * u64(_counts.vertexCount) +
+		sizeof(u32) * u64(_counts.indexCount - _shortIndexCount) + sizeof(u16) * u64(_shortIndexCount);
+
+	if (_bMeshletsRequired)
+	{
+		byteSize += sizeof(Meshlet) * u64(_counts.meshletCount) + sizeof(u32) * u64(_counts.meshletVertexCount) +
+			sizeof(u8) * u64(_counts.meshletTriangleCount) + sizeof(Cluster) * u64(_counts.clusterCount);
 	}
 
-	_rGeometry.meshes.push_back(mesh);
+	return byteSize;
+}
+
+static Buffer createStagingBuffer(
+	Device& _rDevice,
+	u64 _byteSize)
+{
+	return createBuffer(_rDevice, {
+		.byteSize = _byteSize,
+		.access = MemoryAccess::Host,
+		.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT });
 }
 
 GeometryBuffers createGeometryBuffers(
 	Device& _rDevice,
 	u32 _meshCount,
-	const char** _meshPaths)
+	const char** _meshPaths,
+	MeshProcessingDesc _processingDesc)
 {
 	EASY_BLOCK("InitializeGeometry");
 
-	Geometry geometry{};
+	std::vector<MeshGeometrySource> sources(_meshCount);
+
+	// Sources with identical processed streams alias the data of the first one, so only their meshes get uploaded.
+	// Repeated paths are aliased before opening, which also keeps them from importing and saving the same cache twice.
+	std::vector<u32> dataSourceIndices(_meshCount);
+	std::unordered_map<std::string, u32> sourcePaths;
 
 	for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
 	{
-		const char* meshPath = _meshPaths[meshIndex + 1];
-		loadMesh(geometry, meshPath, _rDevice.bMeshShadingPipelineAllowed);
+		dataSourceIndices[meshIndex] = sourcePaths.try_emplace(_meshPaths[meshIndex + 1], meshIndex).first->second;
 	}
 
-	return {
-		.meshletBuffer = _rDevice.bMeshShadingPipelineAllowed ?
+	jobs::parallelFor(_meshCount, [&](u32 _meshIndex)
+		{
+			if (dataSourceIndices[_meshIndex] == _meshIndex)
+			{
+				const char* meshPath = _meshPaths[_meshIndex + 1];
+				openMeshGeometry(sources[_meshIndex], meshPath, _processingDesc);
+			}
+		});
+
+	bool bMeshletsRequired = _rDevice.bMeshShadingPipelineAllowed;
+
+	std::unordered_map<u64, u32> sourceHashes;
+	u32 aliasedSourceCount = 0u;
+	u64 aliasedByteSize = 0ull;
+
+	for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
+	{
+		MeshGeometrySource& rSource = sources[meshIndex];
+		u32& rDataSourceIndex = dataSourceIndices[meshIndex];
+		rDataSourceIndex = dataSourceIndices[rDataSourceIndex];
+
+		if (rDataSourceIndex == meshIndex)
+		{
+			u32 hashSourceIndex = sourceHashes.try_emplace(rSource.hash, meshIndex).first->second;
+			MeshGeometrySource& rHashSource = sources[hashSourceIndex];
+
+			if (hashSourceIndex == meshIndex ||
+				memcmp(&rHashSource.counts, &rSource.counts, sizeof(GeometryCounts)) != 0 ||
+				!isStoredGeometryEqual(rHashSource.cache, rHashSource.geometry, rSource.cache, rSource.geometry))
+			{
+				continue;
+			}
+
+			rDataSourceIndex = hashSourceIndex;
+		}
+
+		if (rDataSourceIndex != meshIndex)
+		{
+			if (rSource.cache.file.pData)
+			{
+				closeGeometryCache(rSource.cache);
+			}
+
+			rSource.geometry = {};
+			rSource.counts = sources[rDataSourceIndex].counts;
+			rSource.shortIndexCount = sources[rDataSourceIndex].shortIndexCount;
+
+			++aliasedSourceCount;
+			aliasedByteSize += getGeometryByteSize(rSource.counts, rSource.shortIndexCount, bMeshletsRequired);
+		}
+	}
+
+	if (aliasedSourceCount > 0u)
+	{
+		printf("Deduplicated %u of %u meshes, %.2f MB saved.\n", aliasedSourceCount, _meshCount, f64(aliasedByteSize) / (1024.0 * 1024.0));
+	}
+
+	// Offsets come from a prefix sum over the stream sizes, which keeps the merged layout
+	// in command line order no matter which mesh finished loading first.
+	std::vector<GeometryCounts> offsets(_meshCount);
+	std::vector<u32> shortIndexOffsets(_meshCount);
+	GeometryCounts totalCounts{};
+	u32 totalShortIndexCount = 0u;
+
+	for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
+	{
+		GeometryCounts counts = sources[meshIndex].counts;
+		offsets[meshIndex] = totalCounts;
+		shortIndexOffsets[meshIndex] = totalShortIndexCount;
+
+		if (dataSourceIndices[meshIndex] != meshIndex)
+		{
+			totalCounts.meshCount += counts.meshCount;
+			totalCounts.instanceCount += counts.instanceCount;
+			continue;
+		}
+
+		totalCounts.meshletCount += counts.meshletCount;
+		totalCounts.meshletVertexCount += counts.meshletVertexCount;
+		totalCounts.meshletTriangleCount += counts.meshletTriangleCount;
+		totalCounts.clusterCount += counts.clusterCount;
+		totalCounts.vertexCount += counts.vertexCount;
+		totalCounts.indexCount += counts.indexCount - sources[meshIndex].shortIndexCount;
+		totalShortIndexCount += sources[meshIndex].shortIndexCount;
+		totalCounts.meshCount += counts.meshCount;
+		totalCounts.pageCount += counts.pageCount;
+		totalCounts.instanceCount += counts.instanceCount;
+	}
+
+	Buffer meshletStagingBuffer = bMeshletsRequired ?
+		createStagingBuffer(_rDevice, sizeof(Meshlet) * u64(totalCounts.meshletCount)) : Buffer();
+
+	Buffer meshletVerticesStagingBuffer = bMeshletsRequired ?
+		createStagingBuffer(_rDevice, sizeof(u32) * u64(totalCounts.meshletVertexCount)) : Buffer();
+
+	Buffer meshletTrianglesStagingBuffer = bMeshletsRequired ?
+		createStagingBuffer(_rDevice, sizeof(u8) * u64(totalCounts.meshletTriangleCount)) : Buffer();
+
+	// Meshes without a cluster hierarchy still get a single element buffer, so the task shader binding is always valid.
+	Buffer clusterStagingBuffer = bMeshletsRequired ?
+		createStagingBuffer(_rDevice, sizeof(Cluster) * u64(glm::max(totalCounts.clusterCount, 1u))) : Buffer();
+
+	Buffer vertexStagingBuffer = createStagingBuffer(_rDevice, sizeof(Vertex) * u64(totalCounts.vertexCount));
+	// Either index pool can be empty, but index buffers still need a valid size.
+	Buffer indexStagingBuffer = createStagingBuffer(_rDevice, sizeof(u32) * u64(glm::max(totalCounts.indexCount, 1u)));
+	Buffer shortIndexStagingBuffer = createStagingBuffer(_rDevice, sizeof(u16) * u64(glm::max(totalShortIndexCount, 2u)));
+	Buffer meshesStagingBuffer = createStagingBuffer(_rDevice, sizeof(Mesh) * u64(totalCounts.meshCount));
+
+	// Instances only drive draw generation, so they stay on the host.
+	std::vector<MeshInstance> instances(totalCounts.instanceCount);
+
+	GeometryStreamPointers stagingStreams = {
+		.pMeshlets = (Meshlet*)meshletStagingBuffer.pMappedData,
+		.pMeshletVertices = (u32*)meshletVerticesStagingBuffer.pMappedData,
+		.pMeshletTriangles = (u8*)meshletTrianglesStagingBuffer.pMappedData,
+		.pClusters = (Cluster*)clusterStagingBuffer.pMappedData,
+		.pVertices = (Vertex*)vertexStagingBuffer.pMappedData,
+		.pIndices = (u32*)indexStagingBuffer.pMappedData,
+		.pMeshes = (Mesh*)meshesStagingBuffer.pMappedData,
+		.pInstances = instances.data() };
+
+	jobs::parallelFor(_meshCount, [&](u32 _meshIndex)
+		{
+			if (dataSourceIndices[_meshIndex] == _meshIndex)
+			{
+				writeMeshGeometry(sources[_meshIndex], offsets[_meshIndex], shortIndexOffsets[_meshIndex],
+					stagingStreams, (u16*)shortIndexStagingBuffer.pMappedData);
+			}
+		});
+
+	// Meshes of the data source already point at its merged data, so aliasing sources take them as they are.
+	for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
+	{
+		if (dataSourceIndices[meshIndex] != meshIndex)
+		{
+			copyStream(stagingStreams.pMeshes + offsets[meshIndex].meshCount, sources[dataSourceIndices[meshIndex]].meshes);
+			copyStream(stagingStreams.pInstances + offsets[meshIndex].instanceCount, sources[dataSourceIndices[meshIndex]].instances);
+		}
+	}
+
+	GeometryBuffers geometryBuffers = {
+		.meshletBuffer = bMeshletsRequired ?
 			createBuffer(_rDevice, {
-				.byteSize = sizeof(Meshlet) * geometry.meshlets.size(),
-				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-				.pContents = geometry.meshlets.data() }) : Buffer(),
+				.byteSize = meshletStagingBuffer.byteSize,
+				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }) : Buffer(),
 
-		.meshletVerticesBuffer = _rDevice.bMeshShadingPipelineAllowed ?
+		.meshletVerticesBuffer = bMeshletsRequired ?
 			createBuffer(_rDevice, {
-				.byteSize = sizeof(u32) * geometry.meshletVertices.size(),
-				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-				.pContents = geometry.meshletVertices.data() }) : Buffer(),
+				.byteSize = meshletVerticesStagingBuffer.byteSize,
+				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }) : Buffer(),
 
-		.meshletTrianglesBuffer = _rDevice.bMeshShadingPipelineAllowed ?
+		.meshletTrianglesBuffer = bMeshletsRequired ?
 			createBuffer(_rDevice, {
-				.byteSize = sizeof(u8) * geometry.meshletTriangles.size(),
-				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-				.pContents = geometry.meshletTriangles.data() }) : Buffer(),
+				.byteSize = meshletTrianglesStagingBuffer.byteSize,
+				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }) : Buffer(),
+
+		.clusterBuffer = bMeshletsRequired ?
+			createBuffer(_rDevice, {
+				.byteSize = clusterStagingBuffer.byteSize,
+				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }) : Buffer(),
 
 		.vertexBuffer = createBuffer(_rDevice, {
-			.byteSize = sizeof(Vertex) * geometry.vertices.size(),
-			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-			.pContents = geometry.vertices.data() }),
+			.byteSize = vertexStagingBuffer.byteSize,
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
 
 		.indexBuffer = createBuffer(_rDevice, {
-			.byteSize = sizeof(u32) * geometry.indices.size(),
-			.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-			.pContents = geometry.indices.data() }),
+			.byteSize = indexStagingBuffer.byteSize,
+			.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
+
+		.shortIndexBuffer = createBuffer(_rDevice, {
+			.byteSize = shortIndexStagingBuffer.byteSize,
+			.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }),
 
 		.meshesBuffer = createBuffer(_rDevice, {
-			.byteSize = sizeof(Mesh) * geometry.meshes.size(),
-			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
-			.pContents = geometry.meshes.data() }) };
+			.byteSize = meshesStagingBuffer.byteSize,
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT }) };
+
+	immediateSubmit(_rDevice, [&](VkCommandBuffer _commandBuffer)
+		{
+			if (bMeshletsRequired)
+			{
+				copyBuffer(_commandBuffer, meshletStagingBuffer, geometryBuffers.meshletBuffer);
+				copyBuffer(_commandBuffer, meshletVerticesStagingBuffer, geometryBuffers.meshletVerticesBuffer);
+				copyBuffer(_commandBuffer, meshletTrianglesStagingBuffer, geometryBuffers.meshletTrianglesBuffer);
+				copyBuffer(_commandBuffer, clusterStagingBuffer, geometryBuffers.clusterBuffer);
+			}
+
+			copyBuffer(_commandBuffer, vertexStagingBuffer, geometryBuffers.vertexBuffer);
+			copyBuffer(_commandBuffer, indexStagingBuffer, geometryBuffers.indexBuffer);
+			copyBuffer(_commandBuffer, shortIndexStagingBuffer, geometryBuffers.shortIndexBuffer);
+			copyBuffer(_commandBuffer, meshesStagingBuffer, geometryBuffers.meshesBuffer);
+		});
+
+	if (bMeshletsRequired)
+	{
+		destroyBuffer(_rDevice, meshletStagingBuffer);
+		destroyBuffer(_rDevice, meshletVerticesStagingBuffer);
+		destroyBuffer(_rDevice, meshletTrianglesStagingBuffer);
+		destroyBuffer(_rDevice, clusterStagingBuffer);
+	}
+
+	destroyBuffer(_rDevice, vertexStagingBuffer);
+	destroyBuffer(_rDevice, indexStagingBuffer);
+	destroyBuffer(_rDevice, shortIndexStagingBuffer);
+	destroyBuffer(_rDevice, meshesStagingBuffer);
+
+	for (GeometryCounts& rOffsets : offsets)
+	{
+		geometryBuffers.sourceMeshOffsets.push_back(rOffsets.meshCount);
+		geometryBuffers.sourceInstanceOffsets.push_back(rOffsets.instanceCount);
+	}
+
+	geometryBuffers.sourceMeshOffsets.push_back(totalCounts.meshCount);
+	geometryBuffers.sourceInstanceOffsets.push_back(totalCounts.instanceCount);
+	geometryBuffers.instances = std::move(instances);
+
+	geometryBuffers.meshes.reserve(totalCounts.meshCount);
+	for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
+	{
+		const std::vector<Mesh>& rMeshes = sources[dataSourceIndices[meshIndex]].meshes;
+		geometryBuffers.meshes.insert(geometryBuffers.meshes.end(), rMeshes.begin(), rMeshes.end());
+	}
+
+	return geometryBuffers;
 }
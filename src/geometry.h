@@ -1,9 +1,10 @@
 #pragma once
 
+// Quantized relative to the Mesh quantization frame.
 struct Vertex
 {
-	u16 position[3];
-	u8 normal[4];
+	i16 position[3];
+	i8 normal[2];
 	u16 texCoord[2];
 };
 
@@ -18,34 +19,122 @@ struct Meshlet
 	f32 radius;
 	i8 coneAxis[3];
 	i8 coneCutoff;
+
+	// Bounding box in the quantization space of its mesh, so it's exact and only takes 12 bytes.
+	i16 boxMin[3];
+	i16 boxMax[3];
+};
+
+// Node of the continuous LOD hierarchy. A cluster is drawn when its own error is small enough on screen
+// and its parent's isn't, where both errors are projected from the bounds of the group they were simplified in.
+struct Cluster
+{
+	f32 center[3];
+	f32 radius;
+	f32 parentCenter[3];
+	f32 parentRadius;
+	f32 error;
+	f32 parentError;     // FLT_MAX for roots.
+	u32 meshletIndex;
+	u32 level;
 };
 
 struct MeshLod
 {
 	u32 indexCount;
 	u32 firstIndex;
+	u32 vertexOffset;    // Mesh vertex offset, unless this LOD got its own compacted vertex range.
+	u32 bShortIndices;   // Every index fits into 16 bits, so the loader moves them into the 16 bit index pool.
 	u32 meshletOffset;
 	u32 meshletCount;
+	u32 pageOffset;
+	u32 pageCount;
+	f32 error;           // Simplification error bound in mesh space, relative to LOD0.
+};
+
+// Self contained chunk of a single LOD's meshlets, streamed into a page pool slot as a whole.
+// Page data stores meshlets, meshlet vertices, meshlet triangles and vertices in that order,
+// with meshlet offsets and meshlet vertices relative to the page.
+struct GeometryPage
+{
+	u32 dataOffset;
+	u32 meshletCount;
+	u32 meshletVertexCount;
+	u32 meshletTriangleCount;
+	u32 vertexCount;
 };
 
+// Spatial chunks of a large mesh are separate meshes, which share its vertex range and quantization frame.
 struct Mesh
 {
 	u32 vertexOffset;
 	f32 center[3];
 	f32 radius;
+	f32 boxCenter[3];
+	f32 boxExtent[3];
+	f32 positionOffset[3];
+	f32 positionScale[3];
+	f32 texCoordOffset[2];
+	f32 texCoordScale[2];
+	u32 clusterOffset;
+	u32 clusterCount;
 	u32 lodCount;
 	MeshLod lods[kMaxMeshLods];
 };
 
+// Scene node, which draws a range of meshes with its column major world transform. Only scene files have them.
+struct MeshInstance
+{
+	f32 transform[16];
+	u32 meshOffset;
+	u32 meshCount;
+};
+
 struct Geometry
 {
 	std::vector<Meshlet> meshlets;
 	std::vector<u32> meshletVertices;
 	std::vector<u8> meshletTriangles;
+	std::vector<Cluster> clusters;
 
 	std::vector<Vertex> vertices;
 	std::vector<u32> indices;
 	std::vector<Mesh> meshes;
+
+	std::vector<GeometryPage> pages;
+	std::vector<u8> pageData;
+
+	std::vector<MeshInstance> instances;
+};
+
+// Element counts of every Geometry stream, also used for offsets into merged streams.
+struct GeometryCounts
+{
+	u32 meshletCount = 0u;
+	u32 meshletVertexCount = 0u;
+	u32 meshletTriangleCount = 0u;
+	u32 clusterCount = 0u;
+	u32 vertexCount = 0u;
+	u32 indexCount = 0u;
+	u32 meshCount = 0u;
+	u32 pageCount = 0u;
+	u32 pageDataByteCount = 0u;
+	u32 instanceCount = 0u;
+};
+
+struct MeshProcessingDesc
+{
+	f32 lodIndexRatio = 0.6f;          // Target index count ratio between two consecutive LODs.
+	f32 lodTargetError = 1e-2f;        // Simplification error limit, relative to the mesh extents.
+	f32 meshletConeWeight = 0.7f;      // Meshlet building bias towards tighter normal cones.
+	bool bParallelLods = false;        // Simplify every LOD from LOD0 and build meshlets in parallel chunks.
+	bool bClusterHierarchy = false;    // Build the continuous LOD cluster hierarchy on top of LOD0 meshlets.
+	bool bStreamingPages = false;      // Split every LOD's meshlets into pages for geometry streaming.
+	u32 chunkTriangleCount = 0u;       // Meshes above this triangle count are split into spatial chunks, zero disables splitting.
+	bool bCompactLodVertices = false;  // Give every LOD past LOD0 its own compacted vertex range.
+	bool bSloppyLods = false;          // Continue the LOD chain with topology agnostic simplification once it stalls.
+	bool bPositionOnlyLods = false;    // Simplify LODs past LOD0 across normal and texture coordinate seams.
+	bool bVerbose = false;             // Print per mesh statistics, some of which take extra passes over the mesh.
 };
 
 struct GeometryBuffers
@@ -53,12 +142,19 @@ struct GeometryBuffers
 	Buffer meshletBuffer{};
 	Buffer meshletVerticesBuffer{};
 	Buffer meshletTrianglesBuffer{};
+	Buffer clusterBuffer{};
 	Buffer vertexBuffer{};
 	Buffer indexBuffer{};
+	Buffer shortIndexBuffer{};            // 16 bit indices of every LOD with bShortIndices set.
 	Buffer meshesBuffer{};
+	std::vector<u32> sourceMeshOffsets;       // First mesh of every source file, followed by the total mesh count.
+	std::vector<u32> sourceInstanceOffsets;   // First scene instance of every source file, followed by the total instance count.
+	std::vector<MeshInstance> instances;      // Scene instances of every source file, with merged mesh offsets.
+	std::vector<Mesh> meshes;                 // Merged meshes, kept on the host for impostor baking and instance bounds.
 };
 
 GeometryBuffers createGeometryBuffers(
 	Device& _rDevice,
 	u32 _meshCount,
-	const char** _meshPaths);
+	const char** _meshPaths,
+	MeshProcessingDesc _processingDesc = {});
@@ -0,0 +1,824 @@
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "utils.h"
+#include "geometry_cache.h"
+#include "gltf_import.h"
+#include "job_system.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <CRC.h>
+#include <meshoptimizer.h>
+#include <filesystem>
+#include <thread>
+#include <atomic>
+
+// Bump whenever the layout of the file changes.
+const u32 kGeometryCacheVersion = 7u;
+const u32 kGeometryCacheMagic = 0x4f454756u; // "VGEO"
+const u64 kGeometryCacheStreamAlignment = 16ull;
+
+const u32 kGeometryCacheCompressedFlag = 1u << 0;
+
+enum GeometryCacheStream : u32
+{
+	kMeshletsStream,
+	kMeshletVerticesStream,
+	kMeshletTrianglesStream,
+	kClustersStream,
+	kVerticesStream,
+	kIndicesStream,
+	kMeshesStream,
+	kPagesStream,
+	kInstancesStream,
+	kPageDataStream,
+	kGeometryCacheStreamCount,
+};
+
+struct GeometryCacheStreamRange
+{
+	u64 offset;
+	u64 byteSize;
+};
+
+struct GeometryCacheHeader
+{
+	u32 magic;
+	u32 version;
+	u32 layoutHash;
+	u32 processingHash;
+	u64 sourceFileSize;
+	i64 sourceWriteTime;
+	u32 flags;
+	u32 headerHash;
+	GeometryCounts counts;
+	GeometryCacheStreamRange streams[kGeometryCacheStreamCount];
+};
+
+// Header hash covers every byte of the header, which only holds if it has no padding.
+static_assert(sizeof(GeometryCacheHeader) ==
+	sizeof(u32) * 6 + sizeof(u64) * 2 + sizeof(GeometryCounts) + sizeof(GeometryCacheStreamRange) * kGeometryCacheStreamCount);
+
+struct SourceStamp
+{
+	u64 fileSize = 0ull;
+	i64 writeTime = 0ll;
+};
+
+// Vertex codec works on elements which are a multiple of 4 bytes in size.
+const size_t kEncodedVertexStride = (sizeof(Vertex) + 3) & ~size_t(3);
+
+static bool tryGetSourceStamp(
+	const char* _pSourcePath,
+	SourceStamp& _rSourceStamp)
+{
+	std::error_code error;
+
+	u64 fileSize = std::filesystem::file_size(_pSourcePath, error);
+	if (error)
+	{
+		return false;
+	}
+
+	std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(_pSourcePath, error);
+	if (error)
+	{
+		return false;
+	}
+
+	_rSourceStamp.fileSize = fileSize;
+	_rSourceStamp.writeTime = i64(writeTime.time_since_epoch().count());
+
+	// Editing an external glTF buffer makes it the newest part of the source, so it shows up as the latest write time.
+	std::vector<std::string> bufferPaths;
+	if (isGltfPath(_pSourcePath) && !tryGetGltfBufferPaths(_pSourcePath, bufferPaths))
+	{
+		return false;
+	}
+
+	for (const std::string& rBufferPath : bufferPaths)
+	{
+		u64 bufferSize = std::filesystem::file_size(rBufferPath, error);
+		if (error)
+		{
+			return false;
+		}
+
+		std::filesystem::file_time_type bufferWriteTime = std::filesystem::last_write_time(rBufferPath, error);
+		if (error)
+		{
+			return false;
+		}
+
+		_rSourceStamp.fileSize += bufferSize;
+		_rSourceStamp.writeTime = glm::max(_rSourceStamp.writeTime, i64(bufferWriteTime.time_since_epoch().count()));
+	}
+
+	return true;
+}
+
+// Streams are stored raw, so any change of their layout invalidates the file.
+static u32 calculateLayoutHash()
+{
+	u32 layout[] = {
+		u32(sizeof(Vertex)),
+		u32(sizeof(Meshlet)),
+		u32(sizeof(Cluster)),
+		u32(sizeof(Mesh)),
+		u32(sizeof(GeometryPage)),
+		u32(sizeof(MeshInstance)),
+		u32(kStreamingPageMeshletCount),
+		u32(kMaxMeshLods),
+		u32(kMaxVerticesPerMeshlet),
+		u32(kMaxTrianglesPerMeshlet) };
+
+	return CRC::Calculate(layout, sizeof(layout), CRC::CRC_32());
+}
+
+// Counts size the staging memory before any encoded stream gets decoded, so the header can't be trusted on its own.
+// Header has no padding, so hashing it with a zeroed hash field covers every byte written to the file.
+static u32 calculateHeaderHash(
+	const GeometryCacheHeader& _rHeader)
+{
+	GeometryCacheHeader header;
+	memcpy(&header, &_rHeader, sizeof(header));
+	header.headerHash = 0u;
+
+	return CRC::Calculate(&header, sizeof(header), CRC::CRC_32());
+}
+
+static u64 getRawStreamByteSize(
+	GeometryCounts _counts,
+	u32 _streamIndex)
+{
+	switch (_streamIndex)
+	{
+	case kMeshletsStream:
+		return sizeof(Meshlet) * u64(_counts.meshletCount);
+
+	case kMeshletVerticesStream:
+		return sizeof(u32) * u64(_counts.meshletVertexCount);
+
+	case kMeshletTrianglesStream:
+		return sizeof(u8) * u64(_counts.meshletTriangleCount);
+
+	case kClustersStream:
+		return sizeof(Cluster) * u64(_counts.clusterCount);
+
+	case kVerticesStream:
+		return sizeof(Vertex) * u64(_counts.vertexCount);
+
+	case kIndicesStream:
+		return sizeof(u32) * u64(_counts.indexCount);
+
+	case kMeshesStream:
+		return sizeof(Mesh) * u64(_counts.meshCount);
+
+	case kPagesStream:
+		return sizeof(GeometryPage) * u64(_counts.pageCount);
+
+	case kInstancesStream:
+		return sizeof(MeshInstance) * u64(_counts.instanceCount);
+
+	case kPageDataStream:
+		return sizeof(u8) * u64(_counts.pageDataByteCount);
+
+	default:
+		assert(!"Unsupported geometry cache stream!");
+		return 0ull;
+	}
+}
+
+static const u8* getStreamData(
+	GeometryCache& _rCache,
+	u32 _streamIndex,
+	u64& _rByteSize)
+{
+	GeometryCacheHeader header;
+	memcpy(&header, _rCache.file.pData, sizeof(header));
+
+	_rByteSize = header.streams[_streamIndex].byteSize;
+	return _rCache.file.pData + header.streams[_streamIndex].offset;
+}
+
+// Meshes, pages and instances are small, and page data gets streamed straight out of the mapped file, so they're never encoded.
+static bool isRawStream(
+	GeometryCache& _rCache,
+	u32 _streamIndex)
+{
+	return !_rCache.bCompressed || _streamIndex >= kMeshesStream;
+}
+
+static std::vector<u8> encodeVertexStream(
+	const void* _pElements,
+	size_t _elementCount,
+	size_t _elementSize)
+{
+	std::vector<u8> encoded(meshopt_encodeVertexBufferBound(_elementCount, _elementSize));
+	encoded.resize(meshopt_encodeVertexBuffer(encoded.data(), encoded.size(), _pElements, _elementCount, _elementSize));
+	return encoded;
+}
+
+static std::vector<u8> encodeVertices(
+	std::vector<Vertex>& _rVertices)
+{
+	if (kEncodedVertexStride == sizeof(Vertex))
+	{
+		return encodeVertexStream(_rVertices.data(), _rVertices.size(), sizeof(Vertex));
+	}
+
+	// Padding bytes are always zero, so they cost next to nothing once encoded.
+	std::vector<u8> paddedVertices(kEncodedVertexStride * _rVertices.size(), 0u);
+	for (size_t vertexIndex = 0; vertexIndex < _rVertices.size(); ++vertexIndex)
+	{
+		memcpy(&paddedVertices[kEncodedVertexStride * vertexIndex], &_rVertices[vertexIndex], sizeof(Vertex));
+	}
+
+	return encodeVertexStream(paddedVertices.data(), _rVertices.size(), kEncodedVertexStride);
+}
+
+static bool decodeVertices(
+	Vertex* _pVertices,
+	u32 _vertexCount,
+	const u8* _pEncoded,
+	u64 _encodedByteSize)
+{
+	if (kEncodedVertexStride == sizeof(Vertex))
+	{
+		return meshopt_decodeVertexBuffer(_pVertices, _vertexCount, sizeof(Vertex), _pEncoded, _encodedByteSize) == 0;
+	}
+
+	std::vector<u8> paddedVertices(kEncodedVertexStride * _vertexCount);
+	if (meshopt_decodeVertexBuffer(paddedVertices.data(), _vertexCount, kEncodedVertexStride, _pEncoded, _encodedByteSize) != 0)
+	{
+		return false;
+	}
+
+	for (u32 vertexIndex = 0; vertexIndex < _vertexCount; ++vertexIndex)
+	{
+		memcpy(&_pVertices[vertexIndex], &paddedVertices[kEncodedVertexStride * vertexIndex], sizeof(Vertex));
+	}
+
+	return true;
+}
+
+// Every LOD is a separate triangle list, encoded as a byte size followed by the index codec output.
+static std::vector<u8> encodeIndices(
+	Geometry& _rGeometry)
+{
+	std::vector<u8> encoded;
+
+	for (Mesh& rMesh : _rGeometry.meshes)
+	{
+		for (u32 lodIndex = 0; lodIndex < rMesh.lodCount; ++lodIndex)
+		{
+			MeshLod& rLod = rMesh.lods[lodIndex];
+
+			std::vector<u8> encodedLod(meshopt_encodeIndexBufferBound(rLod.indexCount, _rGeometry.vertices.size()));
+			encodedLod.resize(meshopt_encodeIndexBuffer(encodedLod.data(), encodedLod.size(),
+				&_rGeometry.indices[rLod.firstIndex], rLod.indexCount));
+
+			u32 encodedLodByteSize = u32(encodedLod.size());
+			encoded.insert(encoded.end(), (u8*)&encodedLodByteSize, (u8*)&encodedLodByteSize + sizeof(encodedLodByteSize));
+			encoded.insert(encoded.end(), encodedLod.begin(), encodedLod.end());
+		}
+	}
+
+	return encoded;
+}
+
+// LOD sizes and ranges come from the file, so each of them is checked before it's used.
+static bool decodeIndices(
+	u32* _pIndices,
+	u32 _indexCount,
+	const Mesh* _pMeshes,
+	u32 _meshCount,
+	const u8* _pEncoded,
+	const u8* _pEncodedEnd)
+{
+	for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
+	{
+		const Mesh& rMesh = _pMeshes[meshIndex];
+
+		if (rMesh.lodCount > kMaxMeshLods)
+		{
+			return false;
+		}
+
+		for (u32 lodIndex = 0; lodIndex < rMesh.lodCount; ++lodIndex)
+		{
+			const MeshLod& rLod = rMesh.lods[lodIndex];
+
+			if (rLod.firstIndex > _indexCount || rLod.indexCount > _indexCount - rLod.firstIndex)
+			{
+				return false;
+			}
+
+			u32 encodedLodByteSize;
+			if (u64(_pEncodedEnd - _pEncoded) < sizeof(encodedLodByteSize))
+			{
+				return false;
+			}
+
+			memcpy(&encodedLodByteSize, _pEncoded, sizeof(encodedLodByteSize));
+			_pEncoded += sizeof(encodedLodByteSize);
+
+			if (u64(_pEncodedEnd - _pEncoded) < encodedLodByteSize ||
+				meshopt_decodeIndexBuffer(&_pIndices[rLod.firstIndex], rLod.indexCount, sizeof(u32), _pEncoded, encodedLodByteSize) != 0)
+			{
+				return false;
+			}
+
+			_pEncoded += encodedLodByteSize;
+		}
+	}
+
+	return _pEncoded == _pEncodedEnd;
+}
+
+// Returns false when an encoded stream doesn't decode into the sizes the header promises.
+static bool readStream(
+	GeometryCache& _rCache,
+	u32 _streamIndex,
+	void* _pDestination,
+	const Mesh* _pMeshes)
+{
+	u64 byteSize;
+	const u8* pData = getStreamData(_rCache, _streamIndex, byteSize);
+
+	GeometryCounts counts = _rCache.counts;
+
+	if (isRawStream(_rCache, _streamIndex))
+	{
+		memcpy(_pDestination, pData, byteSize);
+		return true;
+	}
+
+	switch (_streamIndex)
+	{
+	case kMeshletsStream:
+		return meshopt_decodeVertexBuffer(_pDestination, counts.meshletCount, sizeof(Meshlet), pData, byteSize) == 0;
+
+	case kMeshletVerticesStream:
+		return meshopt_decodeIndexSequence(_pDestination, counts.meshletVertexCount, sizeof(u32), pData, byteSize) == 0;
+
+	case kMeshletTrianglesStream:
+		return counts.meshletTriangleCount % 4 == 0 &&
+			meshopt_decodeVertexBuffer(_pDestination, counts.meshletTriangleCount / 4, 4u, pData, byteSize) == 0;
+
+	case kClustersStream:
+		return meshopt_decodeVertexBuffer(_pDestination, counts.clusterCount, sizeof(Cluster), pData, byteSize) == 0;
+
+	case kVerticesStream:
+		return decodeVertices((Vertex*)_pDestination, counts.vertexCount, pData, byteSize);
+
+	case kIndicesStream:
+		return decodeIndices((u32*)_pDestination, counts.indexCount, _pMeshes, counts.meshCount, pData, pData + byteSize);
+
+	default:
+		assert(!"Unsupported geometry cache stream!");
+		return false;
+	}
+}
+
+std::string getGeometryCachePath(
+	const char* _pSourcePath)
+{
+	return std::string(_pSourcePath) + kGeometryCacheExtension;
+}
+
+bool isGeometryCachePath(
+	const char* _pPath)
+{
+	size_t pathLength = strlen(_pPath);
+	size_t extensionLength = strlen(kGeometryCacheExtension);
+
+	return pathLength >= extensionLength &&
+		strcmp(_pPath + pathLength - extensionLength, kGeometryCacheExtension) == 0;
+}
+
+bool tryOpenGeometryCache(
+	const char* _pCachePath,
+	const char* _pSourcePath,
+	u32 _processingHash,
+	GeometryCache& _rCache)
+{
+	EASY_BLOCK("OpenGeometryCache");
+
+	_rCache = {};
+
+	if (!tryMapFile(_pCachePath, _rCache.file))
+	{
+		return false;
+	}
+
+	bool bValid = _rCache.file.byteSize >= sizeof(GeometryCacheHeader);
+
+	GeometryCacheHeader header{};
+	if (bValid)
+	{
+		memcpy(&header, _rCache.file.pData, sizeof(header));
+
+		bValid = header.magic == kGeometryCacheMagic &&
+			header.version == kGeometryCacheVersion &&
+			header.layoutHash == calculateLayoutHash() &&
+			header.headerHash == calculateHeaderHash(header);
+	}
+
+	if (bValid && _pSourcePath)
+	{
+		SourceStamp sourceStamp;
+		bValid = header.processingHash == _processingHash &&
+			tryGetSourceStamp(_pSourcePath, sourceStamp) &&
+			header.sourceFileSize == sourceStamp.fileSize &&
+			header.sourceWriteTime == sourceStamp.writeTime;
+	}
+
+	_rCache.bCompressed = (header.flags & kGeometryCacheCompressedFlag) != 0u;
+
+	for (u32 streamIndex = 0; bValid && streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		GeometryCacheStreamRange range = header.streams[streamIndex];
+
+		bValid = range.offset <= _rCache.file.byteSize &&
+			range.byteSize <= _rCache.file.byteSize - range.offset;
+
+		// Encoded streams are only validated once they're decoded, see readGeometryCache.
+		if (isRawStream(_rCache, streamIndex))
+		{
+			bValid = bValid && range.byteSize == getRawStreamByteSize(header.counts, streamIndex);
+		}
+	}
+
+	if (!bValid)
+	{
+		closeGeometryCache(_rCache);
+		return false;
+	}
+
+	_rCache.counts = header.counts;
+
+	return true;
+}
+
+const u8* getGeometryCachePageData(
+	GeometryCache& _rCache)
+{
+	u64 byteSize;
+	return getStreamData(_rCache, kPageDataStream, byteSize);
+}
+
+void closeGeometryCache(
+	GeometryCache& _rCache)
+{
+	unmapFile(_rCache.file);
+	_rCache = {};
+}
+
+bool readGeometryCache(
+	GeometryCache& _rCache,
+	GeometryStreamPointers _destination)
+{
+	EASY_BLOCK("ReadGeometryCache");
+
+	u64 meshesByteSize;
+	const Mesh* pMeshes = (const Mesh*)getStreamData(_rCache, kMeshesStream, meshesByteSize);
+
+	void* destinations[kGeometryCacheStreamCount] = {
+		_destination.pMeshlets,
+		_destination.pMeshletVertices,
+		_destination.pMeshletTriangles,
+		_destination.pClusters,
+		_destination.pVertices,
+		_destination.pIndices,
+		_destination.pMeshes,
+		_destination.pPages,
+		_destination.pInstances,
+		nullptr };
+
+	std::atomic<bool> bRead = true;
+
+	jobs::parallelFor(kGeometryCacheStreamCount, [&](u32 _streamIndex)
+		{
+			if (destinations[_streamIndex] && getRawStreamByteSize(_rCache.counts, _streamIndex) > 0ull &&
+				!readStream(_rCache, _streamIndex, destinations[_streamIndex], pMeshes))
+			{
+				bRead = false;
+			}
+		});
+
+	return bRead;
+}
+
+u64 calculateGeometryCacheHash(
+	GeometryCache& _rCache)
+{
+	EASY_BLOCK("HashGeometryCache");
+
+	u64 hash = 0ull;
+
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		u64 byteSize;
+		const u8* pData = getStreamData(_rCache, streamIndex, byteSize);
+		hash = calculateHash64(pData, byteSize, hash);
+	}
+
+	return hash;
+}
+
+// Raw stream contents of imported geometry, laid out as they'd be stored.
+static void getGeometryStreams(
+	const Geometry& _rGeometry,
+	const void** _pStreamContents,
+	u64* _pStreamByteSizes)
+{
+	const void* streamContents[kGeometryCacheStreamCount] = {
+		_rGeometry.meshlets.data(),
+		_rGeometry.meshletVertices.data(),
+		_rGeometry.meshletTriangles.data(),
+		_rGeometry.clusters.data(),
+		_rGeometry.vertices.data(),
+		_rGeometry.indices.data(),
+		_rGeometry.meshes.data(),
+		_rGeometry.pages.data(),
+		_rGeometry.instances.data(),
+		_rGeometry.pageData.data() };
+
+	GeometryCounts counts = {
+		.meshletCount = u32(_rGeometry.meshlets.size()),
+		.meshletVertexCount = u32(_rGeometry.meshletVertices.size()),
+		.meshletTriangleCount = u32(_rGeometry.meshletTriangles.size()),
+		.clusterCount = u32(_rGeometry.clusters.size()),
+		.vertexCount = u32(_rGeometry.vertices.size()),
+		.indexCount = u32(_rGeometry.indices.size()),
+		.meshCount = u32(_rGeometry.meshes.size()),
+		.pageCount = u32(_rGeometry.pages.size()),
+		.pageDataByteCount = u32(_rGeometry.pageData.size()),
+		.instanceCount = u32(_rGeometry.instances.size()) };
+
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		_pStreamContents[streamIndex] = streamContents[streamIndex];
+		_pStreamByteSizes[streamIndex] = getRawStreamByteSize(counts, streamIndex);
+	}
+}
+
+// Streams as they're hashed, out of the mapped cache file when there is one, or out of the imported geometry otherwise.
+static void getStoredStreams(
+	GeometryCache& _rCache,
+	const Geometry& _rGeometry,
+	const void** _pStreamContents,
+	u64* _pStreamByteSizes)
+{
+	if (!_rCache.file.pData)
+	{
+		getGeometryStreams(_rGeometry, _pStreamContents, _pStreamByteSizes);
+		return;
+	}
+
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		_pStreamContents[streamIndex] = getStreamData(_rCache, streamIndex, _pStreamByteSizes[streamIndex]);
+	}
+}
+
+u64 calculateGeometryHash(
+	const Geometry& _rGeometry)
+{
+	EASY_BLOCK("HashGeometry");
+
+	const void* streamContents[kGeometryCacheStreamCount];
+	u64 streamByteSizes[kGeometryCacheStreamCount];
+	getGeometryStreams(_rGeometry, streamContents, streamByteSizes);
+
+	u64 hash = 0ull;
+
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		hash = calculateHash64(streamContents[streamIndex], streamByteSizes[streamIndex], hash);
+	}
+
+	return hash;
+}
+
+bool isStoredGeometryEqual(
+	GeometryCache& _rCache,
+	const Geometry& _rGeometry,
+	GeometryCache& _rOtherCache,
+	const Geometry& _rOtherGeometry)
+{
+	EASY_BLOCK("CompareGeometry");
+
+	// Imported geometry is stored raw, and encoded bytes are only comparable with other encoded bytes.
+	bool bCompressed = _rCache.file.pData && _rCache.bCompressed;
+	bool bOtherCompressed = _rOtherCache.file.pData && _rOtherCache.bCompressed;
+
+	if (bCompressed != bOtherCompressed)
+	{
+		return false;
+	}
+
+	const void* streamContents[kGeometryCacheStreamCount];
+	u64 streamByteSizes[kGeometryCacheStreamCount];
+	getStoredStreams(_rCache, _rGeometry, streamContents, streamByteSizes);
+
+	const void* otherStreamContents[kGeometryCacheStreamCount];
+	u64 otherStreamByteSizes[kGeometryCacheStreamCount];
+	getStoredStreams(_rOtherCache, _rOtherGeometry, otherStreamContents, otherStreamByteSizes);
+
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		if (streamByteSizes[streamIndex] != otherStreamByteSizes[streamIndex] ||
+			(streamByteSizes[streamIndex] > 0ull &&
+				memcmp(streamContents[streamIndex], otherStreamContents[streamIndex], streamByteSizes[streamIndex]) != 0))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool tryLoadGeometryCache(
+	const char* _pCachePath,
+	const char* _pSourcePath,
+	u32 _processingHash,
+	Geometry& _rGeometry)
+{
+	GeometryCache cache;
+	if (!tryOpenGeometryCache(_pCachePath, _pSourcePath, _processingHash, cache))
+	{
+		return false;
+	}
+
+	_rGeometry.meshlets.resize(cache.counts.meshletCount);
+	_rGeometry.meshletVertices.resize(cache.counts.meshletVertexCount);
+	_rGeometry.meshletTriangles.resize(cache.counts.meshletTriangleCount);
+	_rGeometry.clusters.resize(cache.counts.clusterCount);
+	_rGeometry.vertices.resize(cache.counts.vertexCount);
+	_rGeometry.indices.resize(cache.counts.indexCount);
+	_rGeometry.meshes.resize(cache.counts.meshCount);
+	_rGeometry.pages.resize(cache.counts.pageCount);
+	_rGeometry.instances.resize(cache.counts.instanceCount);
+
+	u64 pageDataByteSize;
+	const u8* pPageData = getStreamData(cache, kPageDataStream, pageDataByteSize);
+	_rGeometry.pageData.assign(pPageData, pPageData + pageDataByteSize);
+
+	bool bRead = readGeometryCache(cache, {
+		.pMeshlets = _rGeometry.meshlets.data(),
+		.pMeshletVertices = _rGeometry.meshletVertices.data(),
+		.pMeshletTriangles = _rGeometry.meshletTriangles.data(),
+		.pClusters = _rGeometry.clusters.data(),
+		.pVertices = _rGeometry.vertices.data(),
+		.pIndices = _rGeometry.indices.data(),
+		.pMeshes = _rGeometry.meshes.data(),
+		.pPages = _rGeometry.pages.data(),
+		.pInstances = _rGeometry.instances.data() });
+
+	closeGeometryCache(cache);
+
+	return bRead;
+}
+
+bool saveGeometryCache(
+	const char* _pCachePath,
+	const char* _pSourcePath,
+	u32 _processingHash,
+	Geometry& _rGeometry,
+	bool _bCompress)
+{
+	EASY_BLOCK("SaveGeometryCache");
+
+	GeometryCacheHeader header = {
+		.magic = kGeometryCacheMagic,
+		.version = kGeometryCacheVersion,
+		.layoutHash = calculateLayoutHash(),
+		.processingHash = _processingHash,
+		.flags = _bCompress ? kGeometryCacheCompressedFlag : 0u,
+		.counts = {
+			.meshletCount = u32(_rGeometry.meshlets.size()),
+			.meshletVertexCount = u32(_rGeometry.meshletVertices.size()),
+			.meshletTriangleCount = u32(_rGeometry.meshletTriangles.size()),
+			.clusterCount = u32(_rGeometry.clusters.size()),
+			.vertexCount = u32(_rGeometry.vertices.size()),
+			.indexCount = u32(_rGeometry.indices.size()),
+			.meshCount = u32(_rGeometry.meshes.size()),
+			.pageCount = u32(_rGeometry.pages.size()),
+			.pageDataByteCount = u32(_rGeometry.pageData.size()),
+			.instanceCount = u32(_rGeometry.instances.size()) } };
+
+	if (_pSourcePath)
+	{
+		SourceStamp sourceStamp;
+		if (!tryGetSourceStamp(_pSourcePath, sourceStamp))
+		{
+			return false;
+		}
+
+		header.sourceFileSize = sourceStamp.fileSize;
+		header.sourceWriteTime = sourceStamp.writeTime;
+	}
+
+	const void* streamContents[kGeometryCacheStreamCount] = {
+		_rGeometry.meshlets.data(),
+		_rGeometry.meshletVertices.data(),
+		_rGeometry.meshletTriangles.data(),
+		_rGeometry.clusters.data(),
+		_rGeometry.vertices.data(),
+		_rGeometry.indices.data(),
+		_rGeometry.meshes.data(),
+		_rGeometry.pages.data(),
+		_rGeometry.instances.data(),
+		_rGeometry.pageData.data() };
+
+	u64 streamByteSizes[kGeometryCacheStreamCount];
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		streamByteSizes[streamIndex] = getRawStreamByteSize(header.counts, streamIndex);
+	}
+
+	std::vector<u8> encodedStreams[kGeometryCacheStreamCount];
+
+	if (_bCompress)
+	{
+		assert(_rGeometry.meshletTriangles.size() % 4 == 0);
+
+		encodedStreams[kMeshletsStream] = encodeVertexStream(_rGeometry.meshlets.data(), _rGeometry.meshlets.size(), sizeof(Meshlet));
+		encodedStreams[kMeshletTrianglesStream] = encodeVertexStream(_rGeometry.meshletTriangles.data(), _rGeometry.meshletTriangles.size() / 4, 4u);
+		encodedStreams[kClustersStream] = encodeVertexStream(_rGeometry.clusters.data(), _rGeometry.clusters.size(), sizeof(Cluster));
+		encodedStreams[kVerticesStream] = encodeVertices(_rGeometry.vertices);
+		encodedStreams[kIndicesStream] = encodeIndices(_rGeometry);
+
+		std::vector<u8>& rMeshletVertices = encodedStreams[kMeshletVerticesStream];
+		rMeshletVertices.resize(meshopt_encodeIndexSequenceBound(_rGeometry.meshletVertices.size(), _rGeometry.vertices.size()));
+		rMeshletVertices.resize(meshopt_encodeIndexSequence(rMeshletVertices.data(), rMeshletVertices.size(),
+			_rGeometry.meshletVertices.data(), _rGeometry.meshletVertices.size()));
+
+		for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+		{
+			if (streamIndex < kMeshesStream)
+			{
+				streamContents[streamIndex] = encodedStreams[streamIndex].data();
+				streamByteSizes[streamIndex] = encodedStreams[streamIndex].size();
+			}
+		}
+	}
+
+	u64 fileOffset = sizeof(GeometryCacheHeader);
+	for (u32 streamIndex = 0; streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		fileOffset = (fileOffset + kGeometryCacheStreamAlignment - 1) & ~(kGeometryCacheStreamAlignment - 1);
+
+		header.streams[streamIndex].offset = fileOffset;
+		header.streams[streamIndex].byteSize = streamByteSizes[streamIndex];
+
+		fileOffset += streamByteSizes[streamIndex];
+	}
+
+	header.headerHash = calculateHeaderHash(header);
+
+	// Write into a temporary file first, so a crash never leaves a truncated cache behind.
+	// The name is unique per thread, since the same mesh can be loaded multiple times in parallel.
+	std::string temporaryPath = std::string(_pCachePath) + "." +
+		std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+
+	FILE* file = fopen(temporaryPath.c_str(), "wb");
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	bool bWritten = fwrite(&header, sizeof(header), 1u, file) == 1u;
+	u64 writtenByteSize = sizeof(header);
+
+	const u8 padding[kGeometryCacheStreamAlignment] = {};
+	for (u32 streamIndex = 0; bWritten && streamIndex < kGeometryCacheStreamCount; ++streamIndex)
+	{
+		u64 paddingByteSize = header.streams[streamIndex].offset - writtenByteSize;
+		bWritten = paddingByteSize == 0ull || fwrite(padding, paddingByteSize, 1u, file) == 1u;
+
+		u64 streamByteSize = header.streams[streamIndex].byteSize;
+		bWritten = bWritten && (streamByteSize == 0ull ||
+			fwrite(streamContents[streamIndex], streamByteSize, 1u, file) == 1u);
+
+		writtenByteSize = header.streams[streamIndex].offset + streamByteSize;
+	}
+
+	bWritten = fclose(file) == 0 && bWritten;
+
+	std::error_code error;
+	if (bWritten)
+	{
+		std::filesystem::rename(temporaryPath, _pCachePath, error);
+	}
+
+	if (!bWritten || error)
+	{
+		std::filesystem::remove(temporaryPath, error);
+		return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+// Baked geometry files store a header followed by 16 byte aligned Geometry streams.
+// Streams are either raw, so loading them is a file mapping and a couple of memory copies,
+// or encoded with meshoptimizer's vertex and index codecs, which are decoded straight into their destination.
+
+const char* const kGeometryCacheExtension = ".vgeo";
+
+struct GeometryCache
+{
+	MappedFile file{};
+	GeometryCounts counts{};
+	bool bCompressed = false;
+};
+
+// Destination of every cache stream. Streams with a null pointer are skipped.
+struct GeometryStreamPointers
+{
+	Meshlet* pMeshlets = nullptr;
+	u32* pMeshletVertices = nullptr;
+	u8* pMeshletTriangles = nullptr;
+	Cluster* pClusters = nullptr;
+	Vertex* pVertices = nullptr;
+	u32* pIndices = nullptr;
+	Mesh* pMeshes = nullptr;
+	GeometryPage* pPages = nullptr;
+	MeshInstance* pInstances = nullptr;
+};
+
+std::string getGeometryCachePath(
+	const char* _pSourcePath);
+
+bool isGeometryCachePath(
+	const char* _pPath);
+
+// Without a source path, only the file layout is validated, since baked files
+// keep the processing parameters they were baked with.
+bool tryOpenGeometryCache(
+	const char* _pCachePath,
+	const char* _pSourcePath,
+	u32 _processingHash,
+	GeometryCache& _rCache);
+
+// Page data is always stored raw, so pages can be streamed straight out of the mapped file.
+const u8* getGeometryCachePageData(
+	GeometryCache& _rCache);
+
+void closeGeometryCache(
+	GeometryCache& _rCache);
+
+// Streams are read by worker threads in parallel. Returns false when an encoded stream is corrupt,
+// in which case the destination holds garbage and the source has to be imported again.
+bool readGeometryCache(
+	GeometryCache& _rCache,
+	GeometryStreamPointers _destination);
+
+// Hashes every stream as it's stored, so a raw cache file hashes the same as the geometry it was saved from.
+u64 calculateGeometryCacheHash(
+	GeometryCache& _rCache);
+
+u64 calculateGeometryHash(
+	const Geometry& _rGeometry);
+
+// Hashes only find candidates, so sources are compared byte for byte before one aliases the other.
+// Each side is read out of its cache when the file is mapped, or out of its imported geometry otherwise.
+bool isStoredGeometryEqual(
+	GeometryCache& _rCache,
+	const Geometry& _rGeometry,
+	GeometryCache& _rOtherCache,
+	const Geometry& _rOtherGeometry);
+
+bool tryLoadGeometryCache(
+	const char* _pCachePath,
+	const char* _pSourcePath,
+	u32 _processingHash,
+	Geometry& _rGeometry);
+
+bool saveGeometryCache(
+	const char* _pCachePath,
+	const char* _pSourcePath,
+	u32 _processingHash,
+	Geometry& _rGeometry,
+	bool _bCompress = false);
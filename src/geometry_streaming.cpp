@@ -0,0 +1,679 @@
+#include "core/device.h"
+#include "core/buffer.h"
+#include "core/frame_pacing.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "utils.h"
+#include "geometry_cache.h"
+#include "geometry_streaming.h"
+#include "mesh_import.h"
+#include "job_system.h"
+
+#include <string.h>
+#include <numeric>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace streaming
+{
+	// Upload staging memory per frame in flight, which limits how much geometry gets streamed in a single frame.
+	const u64 kUploadByteSize = 16ull << 20;
+
+	// LODs used in any of the last couple of frames are never evicted, which avoids thrashing around LOD transitions.
+	const u64 kEvictionFrameDelay = 2ull * kMaxFramesInFlightCount;
+
+	const u32 kInvalidPageSlot = ~0u;
+
+	const u64 kPoolMeshletsByteSize = sizeof(Meshlet) * u64(kStreamingPageMeshletCount);
+	const u64 kPoolMeshletVerticesByteSize = sizeof(u32) * u64(kStreamingPageVertexCount);
+	const u64 kPoolMeshletTrianglesByteSize = sizeof(u8) * u64(kStreamingPageTriangleByteCount);
+	const u64 kPoolVerticesByteSize = sizeof(Vertex) * u64(kStreamingPageVertexCount);
+
+	const u64 kPoolPageByteSize = kPoolMeshletsByteSize + kPoolMeshletVerticesByteSize +
+		kPoolMeshletTrianglesByteSize + kPoolVerticesByteSize;
+
+	struct StreamingMesh
+	{
+		GeometryCache cache{};
+		Mesh mesh{};                      // LOD page offsets are global, while page descriptors are per mesh.
+		std::vector<GeometryPage> pages;
+		u32 pageOffset = 0u;              // Global index of the first mesh page.
+	};
+
+	struct StreamingLod
+	{
+		std::vector<u32> pageSlots;
+		u64 lastUsedFrame = 0ull;
+		bool bResident = false;
+		bool bPending = false;
+		bool bPinned = false;
+	};
+
+	struct LoadedLod
+	{
+		u32 lodStateIndex = 0u;
+		std::vector<u8> pageData;   // Data of all LOD pages, in page order.
+	};
+
+	// Copies recorded for a single upload, executed together once all loaded LODs were committed.
+	struct PoolCopies
+	{
+		std::vector<VkBufferCopy> meshlets;
+		std::vector<VkBufferCopy> meshletVertices;
+		std::vector<VkBufferCopy> meshletTriangles;
+		std::vector<VkBufferCopy> vertices;
+	};
+
+	static std::vector<StreamingMesh> gMeshes;
+	static std::vector<StreamingLod> gLods;
+	static std::vector<u32> gFreePageSlots;
+	static u32 gPoolPageCount = 0u;
+	static u64 gFrame = 0ull;
+
+	static GeometryBuffers gPoolBuffers;
+	static GeometryStreamingBuffers gStreamingBuffers;
+	static std::array<Buffer, kMaxFramesInFlightCount> gUploadBuffers;
+
+	static std::thread gStreamerThread;
+	static std::mutex gStreamerMutex;
+	static std::condition_variable gStreamerCondition;
+	static std::deque<u32> gRequestedLods;
+	static std::deque<LoadedLod> gLoadedLods;
+	static bool gbStreamerRunning = false;
+
+	static u64 getPageByteSize(
+		GeometryPage& _rPage)
+	{
+		return sizeof(Meshlet) * u64(_rPage.meshletCount) + sizeof(u32) * u64(_rPage.meshletVertexCount) +
+			sizeof(u8) * u64(_rPage.meshletTriangleCount) + sizeof(Vertex) * u64(_rPage.vertexCount);
+	}
+
+	static void openStreamingMesh(
+		StreamingMesh& _rMesh,
+		const char* _pFilePath,
+		MeshProcessingDesc _processingDesc)
+	{
+		EASY_BLOCK("OpenStreamingMesh");
+
+		u32 processingHash = calculateProcessingHash(_processingDesc);
+
+		if (isGeometryCachePath(_pFilePath))
+		{
+			bool bOpened = tryOpenGeometryCache(_pFilePath, nullptr, processingHash, _rMesh.cache);
+			assert(bOpened && "Baked geometry layout is out of date, bake it again!");
+		}
+		else
+		{
+			// Streamed pages are always read out of a mapped cache file, so imported meshes have to be saved first.
+			std::string cachePath = getGeometryCachePath(_pFilePath);
+
+			if (!tryOpenGeometryCache(cachePath.c_str(), _pFilePath, processingHash, _rMesh.cache))
+			{
+				Geometry geometry;
+				importMesh(geometry, _pFilePath, _processingDesc);
+
+				bool bSaved = saveGeometryCache(cachePath.c_str(), _pFilePath, processingHash, geometry);
+				assert(bSaved && "Streamed geometry has to be backed by a geometry cache file!");
+
+				bool bOpened = tryOpenGeometryCache(cachePath.c_str(), _pFilePath, processingHash, _rMesh.cache);
+				assert(bOpened);
+			}
+		}
+
+		assert(_rMesh.cache.counts.meshCount == 1u && "Streamed geometry can't be split into spatial chunks!");
+		assert(_rMesh.cache.counts.pageCount > 0u && "Geometry has no streaming pages, bake it with --streaming-pages!");
+
+		_rMesh.pages.resize(_rMesh.cache.counts.pageCount);
+
+		bool bRead = readGeometryCache(_rMesh.cache, {
+			.pMeshes = &_rMesh.mesh,
+			.pPages = _rMesh.pages.data() });
+		assert(bRead && "Raw streams are validated when the cache is opened!");
+	}
+
+	static LoadedLod loadLod(
+		u32 _lodStateIndex)
+	{
+		EASY_BLOCK("LoadLod");
+
+		StreamingMesh& rMesh = gMeshes[_lodStateIndex / kMaxMeshLods];
+		MeshLod& rLod = rMesh.mesh.lods[_lodStateIndex % kMaxMeshLods];
+
+		// Pages of a single LOD are stored next to each other, so the whole LOD is a single read.
+		GeometryPage& rFirstPage = rMesh.pages[rLod.pageOffset - rMesh.pageOffset];
+		GeometryPage& rLastPage = rMesh.pages[rLod.pageOffset - rMesh.pageOffset + rLod.pageCount - 1];
+		u64 byteSize = rLastPage.dataOffset + getPageByteSize(rLastPage) - rFirstPage.dataOffset;
+
+		const u8* pPageData = getGeometryCachePageData(rMesh.cache) + rFirstPage.dataOffset;
+
+		LoadedLod loadedLod = { .lodStateIndex = _lodStateIndex };
+		loadedLod.pageData.assign(pPageData, pPageData + byteSize);
+
+		return loadedLod;
+	}
+
+	// Reading from mapped files can page fault on cold data, so it never happens on the main thread.
+	static void runStreamer()
+	{
+		EASY_THREAD("Streamer");
+
+		while (true)
+		{
+			u32 lodStateIndex;
+
+			{
+				std::unique_lock<std::mutex> lock(gStreamerMutex);
+				gStreamerCondition.wait(lock, []() { return !gbStreamerRunning || !gRequestedLods.empty(); });
+
+				if (!gbStreamerRunning)
+				{
+					return;
+				}
+
+				lodStateIndex = gRequestedLods.front();
+				gRequestedLods.pop_front();
+			}
+
+			LoadedLod loadedLod = loadLod(lodStateIndex);
+
+			std::lock_guard<std::mutex> lock(gStreamerMutex);
+			gLoadedLods.push_back(std::move(loadedLod));
+		}
+	}
+
+	static void setLodResidency(
+		VkCommandBuffer _commandBuffer,
+		u32 _lodStateIndex,
+		bool _bResident)
+	{
+		StreamingMesh& rMesh = gMeshes[_lodStateIndex / kMaxMeshLods];
+		MeshLod& rLod = rMesh.mesh.lods[_lodStateIndex % kMaxMeshLods];
+		StreamingLod& rLodState = gLods[_lodStateIndex];
+
+		rLodState.bResident = _bResident;
+
+		std::vector<u32> pageSlots = _bResident ? rLodState.pageSlots : std::vector<u32>(rLod.pageCount, kInvalidPageSlot);
+		vkCmdUpdateBuffer(_commandBuffer, gStreamingBuffers.pageTableBuffer.resource, sizeof(u32) * u64(rLod.pageOffset),
+			sizeof(u32) * pageSlots.size(), pageSlots.data());
+
+		u32 residency = _bResident ? 1u : 0u;
+		vkCmdUpdateBuffer(_commandBuffer, gStreamingBuffers.lodResidencyBuffer.resource, sizeof(u32) * u64(_lodStateIndex),
+			sizeof(u32), &residency);
+	}
+
+	static void evictLod(
+		VkCommandBuffer _commandBuffer,
+		u32 _lodStateIndex)
+	{
+		StreamingLod& rLodState = gLods[_lodStateIndex];
+
+		setLodResidency(_commandBuffer, _lodStateIndex, false);
+
+		gFreePageSlots.insert(gFreePageSlots.end(), rLodState.pageSlots.begin(), rLodState.pageSlots.end());
+		rLodState.pageSlots.clear();
+	}
+
+	static bool tryAllocatePageSlots(
+		VkCommandBuffer _commandBuffer,
+		u32 _pageCount,
+		std::vector<u32>& _rPageSlots)
+	{
+		while (gFreePageSlots.size() < _pageCount)
+		{
+			u32 evictedLodStateIndex = ~0u;
+			u64 oldestFrame = gFrame > kEvictionFrameDelay ? gFrame - kEvictionFrameDelay : 0ull;
+
+			for (u32 lodStateIndex = 0; lodStateIndex < gLods.size(); ++lodStateIndex)
+			{
+				StreamingLod& rLodState = gLods[lodStateIndex];
+
+				if (rLodState.bResident && !rLodState.bPinned && rLodState.lastUsedFrame < oldestFrame)
+				{
+					oldestFrame = rLodState.lastUsedFrame;
+					evictedLodStateIndex = lodStateIndex;
+				}
+			}
+
+			if (evictedLodStateIndex == ~0u)
+			{
+				return false;
+			}
+
+			evictLod(_commandBuffer, evictedLodStateIndex);
+		}
+
+		_rPageSlots.assign(gFreePageSlots.end() - _pageCount, gFreePageSlots.end());
+		gFreePageSlots.resize(gFreePageSlots.size() - _pageCount);
+
+		return true;
+	}
+
+	// Page offsets are patched with the pool slot while copying into staging memory,
+	// so streamed meshlets look exactly like regular ones to the mesh shader.
+	static bool tryCommitLod(
+		VkCommandBuffer _commandBuffer,
+		LoadedLod& _rLoadedLod,
+		Buffer& _rUploadBuffer,
+		u64& _rUploadOffset,
+		PoolCopies& _rCopies)
+	{
+		StreamingMesh& rMesh = gMeshes[_rLoadedLod.lodStateIndex / kMaxMeshLods];
+		MeshLod& rLod = rMesh.mesh.lods[_rLoadedLod.lodStateIndex % kMaxMeshLods];
+		StreamingLod& rLodState = gLods[_rLoadedLod.lodStateIndex];
+
+		if (_rUploadOffset + _rLoadedLod.pageData.size() > _rUploadBuffer.byteSize)
+		{
+			return false;
+		}
+
+		if (!tryAllocatePageSlots(_commandBuffer, rLod.pageCount, rLodState.pageSlots))
+		{
+			return false;
+		}
+
+		u8* pUploadData = (u8*)_rUploadBuffer.pMappedData;
+		const u8* pPageData = _rLoadedLod.pageData.data();
+
+		for (u32 pageIndex = 0; pageIndex < rLod.pageCount; ++pageIndex)
+		{
+			GeometryPage& rPage = rMesh.pages[rLod.pageOffset - rMesh.pageOffset + pageIndex];
+			u32 pageSlot = rLodState.pageSlots[pageIndex];
+
+			assert(rPage.meshletCount <= kStreamingPageMeshletCount);
+			assert(rPage.meshletVertexCount <= kStreamingPageVertexCount && rPage.vertexCount <= kStreamingPageVertexCount);
+			assert(rPage.meshletTriangleCount <= kStreamingPageTriangleByteCount);
+
+			std::vector<Meshlet> meshlets(rPage.meshletCount);
+			memcpy(meshlets.data(), pPageData, sizeof(Meshlet) * meshlets.size());
+			pPageData += sizeof(Meshlet) * meshlets.size();
+
+			for (Meshlet& rMeshlet : meshlets)
+			{
+				rMeshlet.vertexOffset += pageSlot * kStreamingPageVertexCount;
+				rMeshlet.triangleOffset += pageSlot * kStreamingPageTriangleByteCount;
+			}
+
+			std::vector<u32> meshletVertices(rPage.meshletVertexCount);
+			memcpy(meshletVertices.data(), pPageData, sizeof(u32) * meshletVertices.size());
+			pPageData += sizeof(u32) * meshletVertices.size();
+
+			for (u32& rMeshletVertex : meshletVertices)
+			{
+				rMeshletVertex += pageSlot * kStreamingPageVertexCount;
+			}
+
+			u64 meshletsByteSize = sizeof(Meshlet) * meshlets.size();
+			_rCopies.meshlets.push_back({ _rUploadOffset, pageSlot * kPoolMeshletsByteSize, meshletsByteSize });
+			memcpy(pUploadData + _rUploadOffset, meshlets.data(), meshletsByteSize);
+			_rUploadOffset += meshletsByteSize;
+
+			u64 meshletVerticesByteSize = sizeof(u32) * meshletVertices.size();
+			_rCopies.meshletVertices.push_back({ _rUploadOffset, pageSlot * kPoolMeshletVerticesByteSize, meshletVerticesByteSize });
+			memcpy(pUploadData + _rUploadOffset, meshletVertices.data(), meshletVerticesByteSize);
+			_rUploadOffset += meshletVerticesByteSize;
+
+			u64 meshletTrianglesByteSize = sizeof(u8) * rPage.meshletTriangleCount;
+			_rCopies.meshletTriangles.push_back({ _rUploadOffset, pageSlot * kPoolMeshletTrianglesByteSize, meshletTrianglesByteSize });
+			memcpy(pUploadData + _rUploadOffset, pPageData, meshletTrianglesByteSize);
+			_rUploadOffset += meshletTrianglesByteSize;
+			pPageData += meshletTrianglesByteSize;
+
+			u64 verticesByteSize = sizeof(Vertex) * rPage.vertexCount;
+			_rCopies.vertices.push_back({ _rUploadOffset, pageSlot * kPoolVerticesByteSize, verticesByteSize });
+			memcpy(pUploadData + _rUploadOffset, pPageData, verticesByteSize);
+			_rUploadOffset += verticesByteSize;
+			pPageData += verticesByteSize;
+		}
+
+		rLodState.bPending = false;
+		rLodState.lastUsedFrame = gFrame;
+		setLodResidency(_commandBuffer, _rLoadedLod.lodStateIndex, true);
+
+		return true;
+	}
+
+	static void recordPoolCopies(
+		VkCommandBuffer _commandBuffer,
+		Buffer& _rUploadBuffer,
+		PoolCopies& _rCopies)
+	{
+		std::pair<std::vector<VkBufferCopy>*, Buffer*> copies[] = {
+			{ &_rCopies.meshlets, &gPoolBuffers.meshletBuffer },
+			{ &_rCopies.meshletVertices, &gPoolBuffers.meshletVerticesBuffer },
+			{ &_rCopies.meshletTriangles, &gPoolBuffers.meshletTrianglesBuffer },
+			{ &_rCopies.vertices, &gPoolBuffers.vertexBuffer } };
+
+		for (auto [pRegions, pPoolBuffer] : copies)
+		{
+			if (!pRegions->empty())
+			{
+				vkCmdCopyBuffer(_commandBuffer, _rUploadBuffer.resource, pPoolBuffer->resource, u32(pRegions->size()), pRegions->data());
+			}
+		}
+	}
+
+	static void poolBarrier(
+		VkCommandBuffer _commandBuffer,
+		VkAccessFlags _srcAccessMask,
+		VkAccessFlags _dstAccessMask,
+		VkPipelineStageFlags _srcStageMask,
+		VkPipelineStageFlags _dstStageMask)
+	{
+		VkMemoryBarrier memoryBarrier = { VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+		memoryBarrier.srcAccessMask = _srcAccessMask;
+		memoryBarrier.dstAccessMask = _dstAccessMask;
+
+		vkCmdPipelineBarrier(
+			_commandBuffer,
+			_srcStageMask,
+			_dstStageMask,
+			0u,
+			1u, &memoryBarrier,
+			0u, nullptr,
+			0u, nullptr);
+	}
+
+	static Buffer createPoolBuffer(
+		Device& _rDevice,
+		u64 _byteSize)
+	{
+		return createBuffer(_rDevice, {
+			.byteSize = _byteSize,
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT });
+	}
+
+	GeometryBuffers initialize(
+		Device& _rDevice,
+		u32 _meshCount,
+		const char** _meshPaths,
+		MeshProcessingDesc _processingDesc,
+		u64 _poolByteSize,
+		GeometryStreamingBuffers& _rStreamingBuffers)
+	{
+		EASY_BLOCK("InitializeGeometryStreaming");
+
+		assert(_rDevice.bMeshShadingPipelineAllowed);
+
+		_processingDesc.bStreamingPages = true;
+
+		gMeshes.resize(_meshCount);
+		gLods.resize(_meshCount * kMaxMeshLods);
+
+		jobs::parallelFor(_meshCount, [&](u32 _meshIndex)
+			{
+				openStreamingMesh(gMeshes[_meshIndex], _meshPaths[_meshIndex + 1], _processingDesc);
+			});
+
+		std::vector<Mesh> meshes(_meshCount);
+		u32 pageCount = 0u;
+
+		for (u32 meshIndex = 0; meshIndex < _meshCount; ++meshIndex)
+		{
+			StreamingMesh& rMesh = gMeshes[meshIndex];
+			rMesh.pageOffset = pageCount;
+
+			// Page slots already include vertex offsets, and clusters aren't streamed.
+			rMesh.mesh.vertexOffset = 0u;
+			rMesh.mesh.clusterOffset = 0u;
+			rMesh.mesh.clusterCount = 0u;
+
+			for (u32 lodIndex = 0; lodIndex < rMesh.mesh.lodCount; ++lodIndex)
+			{
+				rMesh.mesh.lods[lodIndex].pageOffset += pageCount;
+				rMesh.mesh.lods[lodIndex].vertexOffset = 0u;
+				assert(sizeof(u32) * rMesh.mesh.lods[lodIndex].pageCount <= 65536u && "Page table updates are limited in size!");
+			}
+
+			pageCount += u32(rMesh.pages.size());
+			meshes[meshIndex] = rMesh.mesh;
+
+			gLods[meshIndex * kMaxMeshLods + rMesh.mesh.lodCount - 1].bPinned = true;
+		}
+
+		gPoolPageCount = u32(_poolByteSize / kPoolPageByteSize);
+
+		gFreePageSlots.resize(gPoolPageCount);
+		for (u32 pageSlot = 0; pageSlot < gPoolPageCount; ++pageSlot)
+		{
+			gFreePageSlots[pageSlot] = gPoolPageCount - pageSlot - 1;
+		}
+
+		gPoolBuffers = {
+			.meshletBuffer = createPoolBuffer(_rDevice, kPoolMeshletsByteSize * gPoolPageCount),
+			.meshletVerticesBuffer = createPoolBuffer(_rDevice, kPoolMeshletVerticesByteSize * gPoolPageCount),
+			.meshletTrianglesBuffer = createPoolBuffer(_rDevice, kPoolMeshletTrianglesByteSize * gPoolPageCount),
+
+			// Single element placeholder, so the task shader cluster binding stays valid.
+			.clusterBuffer = createPoolBuffer(_rDevice, sizeof(Cluster)),
+
+			.vertexBuffer = createPoolBuffer(_rDevice, kPoolVerticesByteSize * gPoolPageCount),
+
+			.meshesBuffer = createBuffer(_rDevice, {
+				.byteSize = sizeof(Mesh) * meshes.size(),
+				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+				.pContents = meshes.data() }) };
+
+		gPoolBuffers.meshes = std::move(meshes);
+
+		gPoolBuffers.sourceMeshOffsets.resize(_meshCount + 1);
+		std::iota(gPoolBuffers.sourceMeshOffsets.begin(), gPoolBuffers.sourceMeshOffsets.end(), 0u);
+		gPoolBuffers.sourceInstanceOffsets.resize(_meshCount + 1, 0u);
+
+		std::vector<u32> pageTable(pageCount, kInvalidPageSlot);
+		std::vector<u32> lodResidency(gLods.size(), 0u);
+
+		gStreamingBuffers.pageTableBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(u32) * pageTable.size(),
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			.pContents = pageTable.data() });
+
+		gStreamingBuffers.lodResidencyBuffer = createBuffer(_rDevice, {
+			.byteSize = sizeof(u32) * lodResidency.size(),
+			.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			.pContents = lodResidency.data() });
+
+		for (u32 frameIndex = 0; frameIndex < kMaxFramesInFlightCount; ++frameIndex)
+		{
+			Buffer& rFeedbackBuffer = gStreamingBuffers.feedbackBuffers[frameIndex];
+
+			rFeedbackBuffer = createBuffer(_rDevice, {
+				.byteSize = sizeof(u32) * gLods.size(),
+				.access = MemoryAccess::Readback,
+				.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT });
+
+			memset(rFeedbackBuffer.pMappedData, 0, rFeedbackBuffer.byteSize);
+			vmaFlushAllocation(_rDevice.allocator, rFeedbackBuffer.allocation, 0u, VK_WHOLE_SIZE);
+
+			gUploadBuffers[frameIndex] = createBuffer(_rDevice, {
+				.byteSize = kUploadByteSize,
+				.access = MemoryAccess::Host,
+				.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT });
+		}
+
+		// Coarsest LODs are loaded up front and never evicted, so culling always has something to fall back to.
+		std::vector<LoadedLod> pinnedLods(_meshCount);
+
+		jobs::parallelFor(_meshCount, [&](u32 _meshIndex)
+			{
+				pinnedLods[_meshIndex] = loadLod(_meshIndex * kMaxMeshLods + gMeshes[_meshIndex].mesh.lodCount - 1);
+			});
+
+		u64 pinnedByteSize = 0ull;
+		for (LoadedLod& rLoadedLod : pinnedLods)
+		{
+			pinnedByteSize += rLoadedLod.pageData.size();
+		}
+
+		Buffer pinnedUploadBuffer = createBuffer(_rDevice, {
+			.byteSize = glm::max(pinnedByteSize, u64(sizeof(u32))),
+			.access = MemoryAccess::Host,
+			.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT });
+
+		immediateSubmit(_rDevice, [&](VkCommandBuffer _commandBuffer)
+			{
+				u64 uploadOffset = 0ull;
+				PoolCopies copies;
+
+				for (LoadedLod& rLoadedLod : pinnedLods)
+				{
+					gLods[rLoadedLod.lodStateIndex].bPending = true;
+
+					bool bCommitted = tryCommitLod(_commandBuffer, rLoadedLod, pinnedUploadBuffer, uploadOffset, copies);
+					assert(bCommitted && "Geometry streaming pool can't fit the coarsest LODs of all meshes!");
+				}
+
+				recordPoolCopies(_commandBuffer, pinnedUploadBuffer, copies);
+			});
+
+		destroyBuffer(_rDevice, pinnedUploadBuffer);
+
+		gbStreamerRunning = true;
+		gStreamerThread = std::thread(runStreamer);
+
+		_rStreamingBuffers = gStreamingBuffers;
+
+		return gPoolBuffers;
+	}
+
+	void terminate(
+		Device& _rDevice)
+	{
+		{
+			std::lock_guard<std::mutex> lock(gStreamerMutex);
+			gbStreamerRunning = false;
+		}
+
+		gStreamerCondition.notify_all();
+		gStreamerThread.join();
+
+		for (Buffer& rUploadBuffer : gUploadBuffers)
+		{
+			destroyBuffer(_rDevice, rUploadBuffer);
+		}
+
+		for (StreamingMesh& rMesh : gMeshes)
+		{
+			closeGeometryCache(rMesh.cache);
+		}
+
+		gMeshes.clear();
+		gLods.clear();
+		gFreePageSlots.clear();
+		gRequestedLods.clear();
+		gLoadedLods.clear();
+		gPoolBuffers = {};
+		gStreamingBuffers = {};
+		gUploadBuffers = {};
+	}
+
+	void update(
+		VkCommandBuffer _commandBuffer,
+		Device& _rDevice,
+		u32 _frameIndex)
+	{
+		EASY_BLOCK("UpdateGeometryStreaming");
+
+		++gFrame;
+
+		Buffer& rFeedbackBuffer = gStreamingBuffers.feedbackBuffers[_frameIndex];
+		vmaInvalidateAllocation(_rDevice.allocator, rFeedbackBuffer.allocation, 0u, VK_WHOLE_SIZE);
+
+		const u32* pFeedback = (const u32*)rFeedbackBuffer.pMappedData;
+		std::vector<u32> requestedLods;
+
+		for (u32 lodStateIndex = 0; lodStateIndex < gLods.size(); ++lodStateIndex)
+		{
+			StreamingLod& rLodState = gLods[lodStateIndex];
+			u32 feedback = pFeedback[lodStateIndex];
+
+			if (feedback & kStreamingLodUsed)
+			{
+				rLodState.lastUsedFrame = gFrame;
+			}
+
+			if ((feedback & kStreamingLodRequested) && !rLodState.bResident && !rLodState.bPending)
+			{
+				rLodState.bPending = true;
+				requestedLods.push_back(lodStateIndex);
+			}
+		}
+
+		std::deque<LoadedLod> loadedLods;
+
+		{
+			std::lock_guard<std::mutex> lock(gStreamerMutex);
+			gRequestedLods.insert(gRequestedLods.end(), requestedLods.begin(), requestedLods.end());
+			loadedLods.swap(gLoadedLods);
+		}
+
+		if (!requestedLods.empty())
+		{
+			gStreamerCondition.notify_one();
+		}
+
+		if (!loadedLods.empty())
+		{
+			EASY_BLOCK("CommitLods");
+
+			// Previous frames might still read from pool slots which are about to get overwritten.
+			poolBarrier(_commandBuffer, VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV | VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV,
+				VK_PIPELINE_STAGE_TRANSFER_BIT);
+
+			Buffer& rUploadBuffer = gUploadBuffers[_frameIndex];
+			u64 uploadOffset = 0ull;
+			PoolCopies copies;
+
+			while (!loadedLods.empty())
+			{
+				LoadedLod& rLoadedLod = loadedLods.front();
+
+				if (!tryCommitLod(_commandBuffer, rLoadedLod, rUploadBuffer, uploadOffset, copies))
+				{
+					// Out of upload memory, the rest gets committed next frame.
+					if (rLoadedLod.pageData.size() <= rUploadBuffer.byteSize && uploadOffset > 0ull)
+					{
+						break;
+					}
+
+					// Everything in the pool is in use, or the LOD can never fit, so it's dropped and requested again later.
+					gLods[rLoadedLod.lodStateIndex].bPending = false;
+				}
+
+				loadedLods.pop_front();
+			}
+
+			recordPoolCopies(_commandBuffer, rUploadBuffer, copies);
+
+			poolBarrier(_commandBuffer, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_TRANSFER_BIT,
+				VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TASK_SHADER_BIT_NV | VK_PIPELINE_STAGE_MESH_SHADER_BIT_NV);
+
+			std::lock_guard<std::mutex> lock(gStreamerMutex);
+			gLoadedLods.insert(gLoadedLods.begin(), std::make_move_iterator(loadedLods.begin()), std::make_move_iterator(loadedLods.end()));
+		}
+
+		fillBuffer(_commandBuffer, _rDevice, rFeedbackBuffer, 0u,
+			VK_ACCESS_HOST_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_HOST_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	}
+
+	GeometryStreamingStats getStats()
+	{
+		std::lock_guard<std::mutex> lock(gStreamerMutex);
+
+		u32 pendingLodCount = 0u;
+		for (StreamingLod& rLodState : gLods)
+		{
+			pendingLodCount += rLodState.bPending ? 1u : 0u;
+		}
+
+		return {
+			.residentPageCount = gPoolPageCount - u32(gFreePageSlots.size()),
+			.poolPageCount = gPoolPageCount,
+			.pendingLodCount = pendingLodCount };
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+// Geometry streaming keeps meshlet data in a fixed size device page pool, instead of uploading all of it.
+// Culling writes per mesh LOD feedback, which tells which LODs are used and which are missing.
+// Missing LODs are read from mapped cache files on a streamer thread, then uploaded at the start of a later frame,
+// evicting the least recently used LODs when the pool is full. The coarsest LOD of every mesh is always resident,
+// so culling can fall back to it until the requested LOD arrives.
+
+struct GeometryStreamingBuffers
+{
+	Buffer pageTableBuffer{};                                          // Pool slot of every page, resident LOD pages only.
+	Buffer lodResidencyBuffer{};                                       // Non zero for every resident mesh LOD.
+	std::array<Buffer, kMaxFramesInFlightCount> feedbackBuffers{};    // Feedback of every mesh LOD, per frame in flight.
+};
+
+struct GeometryStreamingStats
+{
+	u32 residentPageCount = 0u;
+	u32 poolPageCount = 0u;
+	u32 pendingLodCount = 0u;
+};
+
+namespace streaming
+{
+	// Meshlet, vertex and mesh buffers of the returned geometry are backed by the page pool,
+	// while index buffers aren't created at all, since only the mesh shading pipeline can draw streamed geometry.
+	GeometryBuffers initialize(
+		Device& _rDevice,
+		u32 _meshCount,
+		const char** _meshPaths,
+		MeshProcessingDesc _processingDesc,
+		u64 _poolByteSize,
+		GeometryStreamingBuffers& _rStreamingBuffers);
+
+	void terminate(
+		Device& _rDevice);
+
+	// Reads back feedback of the frame which used these frame resources last, and records uploads of the loaded LODs.
+	// Has to be called after the frame fence was waited on, before any culling work is recorded.
+	void update(
+		VkCommandBuffer _commandBuffer,
+		Device& _rDevice,
+		u32 _frameIndex);
+
+	GeometryStreamingStats getStats();
+}
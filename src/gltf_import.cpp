@@ -0,0 +1,359 @@
+#include "core/device.h"
+#include "core/buffer.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "mesh_import.h"
+#include "gltf_import.h"
+#include "utils.h"
+
+#define CGLTF_IMPLEMENTATION
+#include <cgltf.h>
+#include <meshoptimizer.h>
+#include <string.h>
+#include <filesystem>
+
+static bool hasExtension(
+	const char* _pPath,
+	const char* _pExtension)
+{
+	size_t pathLength = strlen(_pPath);
+	size_t extensionLength = strlen(_pExtension);
+
+	return pathLength >= extensionLength &&
+		strcmp(_pPath + pathLength - extensionLength, _pExtension) == 0;
+}
+
+// Tightly packed float accessors are read straight out of the mapped file, anything else goes through cgltf's conversion.
+static const u8* getAccessorData(
+	const cgltf_accessor* _pAccessor)
+{
+	if (_pAccessor->is_sparse || !_pAccessor->buffer_view || !_pAccessor->buffer_view->buffer->data)
+	{
+		return nullptr;
+	}
+
+	return (const u8*)_pAccessor->buffer_view->buffer->data + _pAccessor->buffer_view->offset + _pAccessor->offset;
+}
+
+static void readFloatAccessor(
+	const cgltf_accessor* _pAccessor,
+	u32 _componentCount,
+	f32* _pDestination,
+	size_t _destinationStride)
+{
+	const u8* pSource = _pAccessor->component_type == cgltf_component_type_r_32f && !_pAccessor->normalized &&
+		cgltf_num_components(_pAccessor->type) == _componentCount ? getAccessorData(_pAccessor) : nullptr;
+
+	for (size_t elementIndex = 0; elementIndex < _pAccessor->count; ++elementIndex)
+	{
+		f32* pElement = (f32*)((u8*)_pDestination + elementIndex * _destinationStride);
+
+		if (pSource)
+		{
+			memcpy(pElement, pSource + elementIndex * _pAccessor->stride, sizeof(f32) * _componentCount);
+		}
+		else
+		{
+			cgltf_accessor_read_float(_pAccessor, elementIndex, pElement, _componentCount);
+		}
+	}
+}
+
+static void readIndexAccessor(
+	const cgltf_accessor* _pAccessor,
+	u32* _pDestination)
+{
+	const u8* pSource = getAccessorData(_pAccessor);
+
+	for (size_t index = 0; index < _pAccessor->count; ++index)
+	{
+		const u8* pIndex = pSource + index * _pAccessor->stride;
+
+		switch (pSource ? _pAccessor->component_type : cgltf_component_type_invalid)
+		{
+		case cgltf_component_type_r_8u:
+			_pDestination[index] = *pIndex;
+			break;
+
+		case cgltf_component_type_r_16u:
+			_pDestination[index] = *(const u16*)pIndex;
+			break;
+
+		case cgltf_component_type_r_32u:
+			_pDestination[index] = *(const u32*)pIndex;
+			break;
+
+		default:
+			_pDestination[index] = u32(cgltf_accessor_read_index(_pAccessor, index));
+			break;
+		}
+	}
+}
+
+// Area weighted vertex normals, for primitives which come without them.
+static void calculateNormals(
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices)
+{
+	std::vector<v3> normals(_rVertices.size(), v3(0.0f));
+
+	for (size_t index = 0; index < _rIndices.size(); index += 3)
+	{
+		v3 positions[3];
+
+		for (u32 corner = 0; corner < 3; ++corner)
+		{
+			const RawVertex& rVertex = _rVertices[_rIndices[index + corner]];
+			positions[corner] = v3(rVertex.position[0], rVertex.position[1], rVertex.position[2]);
+		}
+
+		v3 normal = glm::cross(positions[1] - positions[0], positions[2] - positions[0]);
+
+		for (u32 corner = 0; corner < 3; ++corner)
+		{
+			normals[_rIndices[index + corner]] += normal;
+		}
+	}
+
+	for (size_t vertexIndex = 0; vertexIndex < _rVertices.size(); ++vertexIndex)
+	{
+		f32 length = glm::length(normals[vertexIndex]);
+		v3 normal = length > 0.0f ? normals[vertexIndex] / length : v3(0.0f, 1.0f, 0.0f);
+
+		memcpy(_rVertices[vertexIndex].normal, &normal[0], sizeof(RawVertex::normal));
+	}
+}
+
+static bool tryReadPrimitive(
+	const cgltf_primitive& _rPrimitive,
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices)
+{
+	if (_rPrimitive.type != cgltf_primitive_type_triangles)
+	{
+		return false;
+	}
+
+	const cgltf_accessor* pPositions = nullptr;
+	const cgltf_accessor* pNormals = nullptr;
+	const cgltf_accessor* pTexCoords = nullptr;
+
+	for (size_t attributeIndex = 0; attributeIndex < _rPrimitive.attributes_count; ++attributeIndex)
+	{
+		const cgltf_attribute& rAttribute = _rPrimitive.attributes[attributeIndex];
+
+		if (rAttribute.type == cgltf_attribute_type_position)
+		{
+			pPositions = rAttribute.data;
+		}
+		else if (rAttribute.type == cgltf_attribute_type_normal)
+		{
+			pNormals = rAttribute.data;
+		}
+		else if (rAttribute.type == cgltf_attribute_type_texcoord && rAttribute.index == 0)
+		{
+			pTexCoords = rAttribute.data;
+		}
+	}
+
+	if (!pPositions || pPositions->count == 0)
+	{
+		return false;
+	}
+
+	_rVertices.assign(pPositions->count, RawVertex{});
+	readFloatAccessor(pPositions, 3u, _rVertices[0].position, sizeof(RawVertex));
+
+	if (pTexCoords)
+	{
+		readFloatAccessor(pTexCoords, 2u, _rVertices[0].texCoord, sizeof(RawVertex));
+	}
+
+	if (_rPrimitive.indices)
+	{
+		_rIndices.resize(_rPrimitive.indices->count);
+		readIndexAccessor(_rPrimitive.indices, _rIndices.data());
+	}
+	else
+	{
+		_rIndices.resize(_rVertices.size());
+
+		for (u32 index = 0; index < u32(_rIndices.size()); ++index)
+		{
+			_rIndices[index] = index;
+		}
+	}
+
+	_rIndices.resize(_rIndices.size() - _rIndices.size() % 3);
+
+	if (pNormals)
+	{
+		readFloatAccessor(pNormals, 3u, _rVertices[0].normal, sizeof(RawVertex));
+	}
+	else
+	{
+		calculateNormals(_rVertices, _rIndices);
+	}
+
+	// Unindexed primitives and exporters which split vertices per face both get their duplicates merged here.
+	std::vector<u32> remap(_rVertices.size());
+	size_t vertexCount = meshopt_generateVertexRemap(remap.data(), _rIndices.data(), _rIndices.size(),
+		_rVertices.data(), _rVertices.size(), sizeof(RawVertex));
+
+	meshopt_remapIndexBuffer(_rIndices.data(), _rIndices.data(), _rIndices.size(), remap.data());
+	meshopt_remapVertexBuffer(_rVertices.data(), _rVertices.data(), _rVertices.size(), sizeof(RawVertex), remap.data());
+	_rVertices.resize(vertexCount);
+
+	return !_rIndices.empty();
+}
+
+bool isGltfPath(
+	const char* _pPath)
+{
+	return hasExtension(_pPath, ".gltf") || hasExtension(_pPath, ".glb");
+}
+
+bool tryGetGltfBufferPaths(
+	const char* _pFilePath,
+	std::vector<std::string>& _rBufferPaths)
+{
+	_rBufferPaths.clear();
+
+	// Binary chunk of a .glb holds its buffers, so only .gltf files are parsed for their buffer URIs.
+	if (!hasExtension(_pFilePath, ".gltf"))
+	{
+		return true;
+	}
+
+	cgltf_options options = {};
+	cgltf_data* pData = nullptr;
+
+	if (cgltf_parse_file(&options, _pFilePath, &pData) != cgltf_result_success)
+	{
+		return false;
+	}
+
+	std::filesystem::path directory = std::filesystem::path(_pFilePath).parent_path();
+
+	for (size_t bufferIndex = 0; bufferIndex < pData->buffers_count; ++bufferIndex)
+	{
+		const char* pUri = pData->buffers[bufferIndex].uri;
+		if (!pUri || strncmp(pUri, "data:", 5) == 0)
+		{
+			continue;
+		}
+
+		std::string uri = pUri;
+		uri.resize(cgltf_decode_uri(uri.data()));
+
+		_rBufferPaths.push_back((directory / uri).string());
+	}
+
+	cgltf_free(pData);
+
+	return true;
+}
+
+// Nodes outside the scene are never drawn, so instances are collected by walking the node tree of the scene.
+static void addNodeInstances(
+	Geometry& _rGeometry,
+	const cgltf_data* _pData,
+	const cgltf_node& _rNode,
+	const std::vector<uv2>& _rMeshRanges)
+{
+	if (_rNode.mesh && _rMeshRanges[_rNode.mesh - _pData->meshes].y > 0u)
+	{
+		uv2 meshRange = _rMeshRanges[_rNode.mesh - _pData->meshes];
+
+		MeshInstance& rInstance = _rGeometry.instances.emplace_back();
+		rInstance.meshOffset = meshRange.x;
+		rInstance.meshCount = meshRange.y;
+
+		cgltf_node_transform_world(&_rNode, rInstance.transform);
+	}
+
+	for (size_t childIndex = 0; childIndex < _rNode.children_count; ++childIndex)
+	{
+		addNodeInstances(_rGeometry, _pData, *_rNode.children[childIndex], _rMeshRanges);
+	}
+}
+
+void importGltfScene(
+	Geometry& _rGeometry,
+	const char* _pFilePath,
+	MeshProcessingDesc _processingDesc)
+{
+	EASY_BLOCK("ImportGltfScene");
+
+	// Binary chunk of a .glb stays inside the mapped file, since cgltf points the first buffer straight at it.
+	// External buffers of a .gltf are loaded by cgltf.
+	MappedFile file;
+	bool bMapped = tryMapFile(_pFilePath, file);
+	assert(bMapped);
+
+	cgltf_options options = {};
+	cgltf_data* pData = nullptr;
+
+	cgltf_result result = cgltf_parse(&options, file.pData, file.byteSize, &pData);
+	assert(result == cgltf_result_success);
+
+	result = cgltf_load_buffers(&options, pData, _pFilePath);
+	assert(result == cgltf_result_success);
+
+	// Meshes of every glTF mesh are contiguous, so a node only needs their range.
+	std::vector<uv2> meshRanges(pData->meshes_count, uv2(0u));
+	std::vector<RawVertex> vertices;
+	std::vector<u32> indices;
+
+	for (size_t meshIndex = 0; meshIndex < pData->meshes_count; ++meshIndex)
+	{
+		const cgltf_mesh& rMesh = pData->meshes[meshIndex];
+		meshRanges[meshIndex].x = u32(_rGeometry.meshes.size());
+
+		for (size_t primitiveIndex = 0; primitiveIndex < rMesh.primitives_count; ++primitiveIndex)
+		{
+			if (!tryReadPrimitive(rMesh.primitives[primitiveIndex], vertices, indices))
+			{
+				continue;
+			}
+
+			char name[512];
+			snprintf(name, sizeof(name), "%s:%s/%zu", _pFilePath, rMesh.name ? rMesh.name : "mesh", primitiveIndex);
+
+			importMeshData(_rGeometry, vertices, indices, name, _processingDesc);
+		}
+
+		meshRanges[meshIndex].y = u32(_rGeometry.meshes.size()) - meshRanges[meshIndex].x;
+	}
+
+	// Default scene is optional, in which case the first one is drawn. Files without any scene only have root nodes to go by.
+	const cgltf_scene* pScene = pData->scene ? pData->scene : pData->scenes_count > 0 ? &pData->scenes[0] : nullptr;
+
+	if (pScene)
+	{
+		for (size_t nodeIndex = 0; nodeIndex < pScene->nodes_count; ++nodeIndex)
+		{
+			addNodeInstances(_rGeometry, pData, *pScene->nodes[nodeIndex], meshRanges);
+		}
+	}
+	else
+	{
+		for (size_t nodeIndex = 0; nodeIndex < pData->nodes_count; ++nodeIndex)
+		{
+			if (!pData->nodes[nodeIndex].parent)
+			{
+				addNodeInstances(_rGeometry, pData, pData->nodes[nodeIndex], meshRanges);
+			}
+		}
+	}
+
+	printf("Imported %s, %zu meshes from %zu glTF meshes, drawn by %zu nodes.\n",
+		_pFilePath, _rGeometry.meshes.size(), pData->meshes_count, _rGeometry.instances.size());
+
+	cgltf_free(pData);
+	unmapFile(file);
+
+	assert(!_rGeometry.meshes.empty() && "glTF scene doesn't have any triangle primitives!");
+	assert(!_rGeometry.instances.empty() && "glTF scene doesn't have any nodes with triangle primitives!");
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+// glTF 2.0 scenes are imported with every triangle primitive as a separate mesh, and every node of the scene which references
+// a mesh as a MeshInstance with its world transform, so meshes used by many nodes are only processed and stored once.
+
+bool isGltfPath(
+	const char* _pPath);
+
+// External buffers of a .gltf file, which are as much a part of the source as the file itself.
+bool tryGetGltfBufferPaths(
+	const char* _pFilePath,
+	std::vector<std::string>& _rBufferPaths);
+
+void importGltfScene(
+	Geometry& _rGeometry,
+	const char* _pFilePath,
+	MeshProcessingDesc _processingDesc);
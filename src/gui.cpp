@@ -354,6 +354,14 @@ namespace gui
 				ImGui::Text("Compute Shader Invocations:  %lld", _rSettings.computeShaderInvocations);
 			}
 
+			if (_rSettings.bGeometryStreamingEnabled)
+			{
+				ImGui::Separator();
+
+				ImGui::Text("Streaming Resident Pages:    %u / %u", _rSettings.streamingResidentPageCount, _rSettings.streamingPoolPageCount);
+				ImGui::Text("Streaming Pending Lods:      %u", _rSettings.streamingPendingLodCount);
+			}
+
 			ImGui::End();
 		}
 
@@ -372,16 +380,35 @@ namespace gui
 			ImGui::SameLine();
 			ImGui::SliderInt("##Forced Lod", &_rSettings.forcedLod, 0, kMaxMeshLods - 1);
 			ImGui::EndDisabled();
+			ImGui::BeginDisabled(_rSettings.bForceMeshLodEnabled);
+			ImGui::SliderFloat("Lod Pixel Error", &_rSettings.lodPixelError, 0.25f, 8.0f, "%.2f px");
+			ImGui::EndDisabled();
+			ImGui::BeginDisabled(!_rSettings.bImpostorsSupported);
+			ImGui::Checkbox("Impostors", &_rSettings.bImpostorsEnabled);
+			ImGui::BeginDisabled(!_rSettings.bImpostorsEnabled);
+			ImGui::SameLine();
+			ImGui::SliderFloat("##Impostor Pixel Radius", &_rSettings.impostorPixelRadius, 1.0f, 64.0f, "%.1f px");
+			ImGui::EndDisabled();
+			ImGui::EndDisabled();
 			ImGui::Checkbox("Mesh Frustum Culling", &_rSettings.bMeshFrustumCullingEnabled);
 			ImGui::Checkbox("Mesh Occlusion Culling", &_rSettings.bMeshOcclusionCullingEnabled);
+			ImGui::Checkbox("Box Culling", &_rSettings.bBoxCullingEnabled);
 			ImGui::Checkbox("Freeze Camera", &_rSettings.bFreezeCameraEnabled);
 			ImGui::Separator();
 
 			ImGui::BeginDisabled(!_rSettings.bMeshShadingPipelineSupported);
+
+			// Streamed geometry only exists in the page pool, which only the mesh shading pipeline can draw.
+			ImGui::BeginDisabled(_rSettings.bGeometryStreamingEnabled);
 			ImGui::Checkbox("Mesh Shading Pipeline", &_rSettings.bMeshShadingPipelineEnabled);
+			ImGui::EndDisabled();
+
 			ImGui::BeginDisabled(!_rSettings.bMeshShadingPipelineEnabled);
 			ImGui::Checkbox("Meshlet Cone Culling", &_rSettings.bMeshletConeCullingEnabled);
 			ImGui::Checkbox("Meshlet Frustum Culling", &_rSettings.bMeshletFrustumCullingEnabled);
+			ImGui::BeginDisabled(_rSettings.bGeometryStreamingEnabled);
+			ImGui::Checkbox("Cluster Lod", &_rSettings.bClusterLodEnabled);
+			ImGui::EndDisabled();
 			ImGui::EndDisabled();
 			ImGui::EndDisabled();
 
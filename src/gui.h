@@ -12,15 +12,25 @@ struct Settings
 	u64 clippingPrimitives = 0ull;
 	u64 fragmentShaderInvocations = 0ull;
 	u64 computeShaderInvocations = 0ull;
+	u32 streamingResidentPageCount = 0u;
+	u32 streamingPoolPageCount = 0u;
+	u32 streamingPendingLodCount = 0u;
 	i32 forcedLod = 0;
+	f32 lodPixelError = 1.0f;
+	f32 impostorPixelRadius = 8.0f;
 	bool bForceMeshLodEnabled = false;
 	bool bFreezeCameraEnabled = false;
 	bool bMeshShadingPipelineSupported = false;
 	bool bMeshShadingPipelineEnabled = false;
 	bool bMeshFrustumCullingEnabled = false;
 	bool bMeshOcclusionCullingEnabled = false;
+	bool bBoxCullingEnabled = false;
 	bool bMeshletConeCullingEnabled = false;
 	bool bMeshletFrustumCullingEnabled = false;
+	bool bClusterLodEnabled = false;
+	bool bGeometryStreamingEnabled = false;
+	bool bImpostorsSupported = false;
+	bool bImpostorsEnabled = false;
 };
 
 namespace gui
@@ -0,0 +1,158 @@
+#include "core/device.h"
+#include "core/buffer.h"
+#include "core/texture.h"
+#include "core/shader.h"
+#include "core/pipeline.h"
+#include "core/pass.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "impostor.h"
+
+Texture createImpostorAtlas(
+	Device& _rDevice,
+	GeometryBuffers& _rGeometryBuffers)
+{
+	EASY_BLOCK("BakeImpostors");
+
+	const std::vector<Mesh>& rMeshes = _rGeometryBuffers.meshes;
+	assert(!rMeshes.empty());
+
+	u32 maxTileCount = kMaxImpostorAtlasSize / kImpostorTileSize;
+	u32 meshCount = glm::min(u32(rMeshes.size()), maxTileCount * maxTileCount);
+
+	if (meshCount < rMeshes.size())
+	{
+		printf("Impostor atlas only fits %u of %u meshes.\n", meshCount, u32(rMeshes.size()));
+	}
+
+	// Tiles are laid out in a square, which is as small as the mesh count allows.
+	u32 tileCount = 1u;
+	while (tileCount * tileCount < meshCount)
+	{
+		++tileCount;
+	}
+
+	u32 atlasSize = tileCount * kImpostorTileSize;
+
+	printf("Impostor atlas is %ux%u for %u meshes, %.2f MB.\n", atlasSize, atlasSize, meshCount,
+		f64(sizeof(u32) * u64(atlasSize) * atlasSize) / (1024.0 * 1024.0));
+
+	// Octahedral normal and depth take 10 bits each, while the 2 bit alpha marks covered texels.
+	Texture impostorAtlas = createTexture(_rDevice, {
+		.width = atlasSize,
+		.height = atlasSize,
+		.format = VK_FORMAT_A2B10G10R10_UNORM_PACK32,
+		.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+		.access = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		.sampler = {
+			.filterMode = VK_FILTER_LINEAR,
+			.addressMode = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE } });
+
+	Texture depthTexture = createTexture(_rDevice, {
+		.width = atlasSize,
+		.height = atlasSize,
+		.format = VK_FORMAT_D32_SFLOAT,
+		.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
+		.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+		.access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT });
+
+	Shader vertShader = createShader(_rDevice, {
+		.pPath = "shaders/impostor_bake.vert.spv",
+		.pEntry = "main" });
+
+	Shader fragShader = createShader(_rDevice, {
+		.pPath = "shaders/impostor_bake.frag.spv",
+		.pEntry = "main" });
+
+	// Frames are seen from both sides of the mesh, so nothing gets culled by winding.
+	Pipeline bakePipeline = createGraphicsPipeline(_rDevice, {
+		.shaders = { vertShader, fragShader },
+		.attachmentLayout = {
+			.colorAttachments = { {
+				.format = impostorAtlas.format } },
+			.depthStencilFormat = { depthTexture.format }},
+		.rasterization = {
+			.cullMode = VK_CULL_MODE_NONE },
+		.depthStencil = {
+			.bDepthTestEnable = true,
+			.bDepthWriteEnable = true,
+			.depthCompareOp = VK_COMPARE_OP_GREATER } });
+
+	destroyShader(_rDevice, fragShader);
+	destroyShader(_rDevice, vertShader);
+
+	immediateSubmit(_rDevice, [&](VkCommandBuffer _commandBuffer)
+		{
+			executePass(_commandBuffer, {
+				.pipeline = bakePipeline,
+				.viewport = {
+					.offset = { 0.0f, 0.0f },
+					.extent = { f32(atlasSize), f32(atlasSize) }},
+				.scissor = {
+					.offset = { 0, 0 },
+					.extent = { atlasSize, atlasSize }},
+				.colorAttachments = {{
+					.texture = impostorAtlas,
+					.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+					.clear = { { 0.0f, 0.0f, 0.0f, 0.0f } } }},
+				.depthStencilAttachment = {
+					.texture = depthTexture,
+					.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+					.clear = { 0.0f, 0 } },
+				.bindings = {
+					Binding(_rGeometryBuffers.vertexBuffer),
+					Binding(_rGeometryBuffers.meshesBuffer) } },
+					[&]()
+				{
+					// Every frame is drawn into its own viewport, with the mesh and frame passed through push constants.
+					for (u32 meshIndex = 0; meshIndex < meshCount; ++meshIndex)
+					{
+						const MeshLod& rLod = rMeshes[meshIndex].lods[0];
+
+						vkCmdBindIndexBuffer(_commandBuffer,
+							rLod.bShortIndices ? _rGeometryBuffers.shortIndexBuffer.resource : _rGeometryBuffers.indexBuffer.resource,
+							0u, rLod.bShortIndices ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
+
+						uv2 tileOffset = u32(kImpostorTileSize) * uv2(meshIndex % tileCount, meshIndex / tileCount);
+
+						for (u32 frameIndex = 0; frameIndex < kImpostorFrameCount * kImpostorFrameCount; ++frameIndex)
+						{
+							uv2 frameOffset = tileOffset + u32(kImpostorFrameSize) * uv2(frameIndex % kImpostorFrameCount, frameIndex / kImpostorFrameCount);
+
+							VkViewport viewport = {
+								.x = f32(frameOffset.x),
+								.y = f32(frameOffset.y),
+								.width = f32(kImpostorFrameSize),
+								.height = f32(kImpostorFrameSize),
+								.minDepth = 0.0f,
+								.maxDepth = 1.0f };
+
+							vkCmdSetViewport(_commandBuffer, 0u, 1u, &viewport);
+
+							struct
+							{
+								u32 meshIndex;
+								u32 frameIndex;
+							} bakeData = { meshIndex, frameIndex };
+
+							vkCmdPushConstants(_commandBuffer, bakePipeline.pipelineLayout,
+								bakePipeline.pushConstants.stageFlags, 0u, sizeof(bakeData), &bakeData);
+
+							vkCmdDrawIndexed(_commandBuffer, rLod.indexCount, 1u, rLod.firstIndex, i32(rLod.vertexOffset), 0u);
+						}
+					}
+				});
+
+			textureBarrier(_commandBuffer, impostorAtlas,
+				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+				VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+		});
+
+	destroyPipeline(_rDevice, bakePipeline);
+	destroyTexture(_rDevice, depthTexture);
+
+	return impostorAtlas;
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+// Impostors are baked on the GPU from LOD0 of every mesh, into an atlas with a square tile per mesh.
+// Every tile holds an octahedral grid of orthographic frames of the mesh bounding sphere, each storing
+// the octahedral mesh space normal and the depth relative to the sphere center, in units of its radius.
+// Meshes which don't fit into the largest atlas never switch to impostors.
+Texture createImpostorAtlas(
+	Device& _rDevice,
+	GeometryBuffers& _rGeometryBuffers);
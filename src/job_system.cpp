@@ -0,0 +1,214 @@
+#include "job_system.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+namespace jobs
+{
+	struct Job
+	{
+		std::function<void(u32)> const* pCallback = nullptr;
+		u32 index = 0u;
+		std::atomic<u32>* pPendingCount = nullptr;
+	};
+
+	struct JobQueue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	// Queue 0 is shared by all threads which aren't workers, the main thread included.
+	static std::vector<std::unique_ptr<JobQueue>> gQueues;
+	static std::vector<std::thread> gWorkers;
+
+	static std::atomic<u32> gQueuedJobCount = 0u;
+	static std::atomic<bool> gbRunning = false;
+	static std::mutex gWakeMutex;
+	static std::condition_variable gWakeCondition;
+
+	static thread_local u32 tQueueIndex = 0u;
+
+	static bool tryPopJob(
+		Job& _rJob)
+	{
+		if (gQueues.empty())
+		{
+			return false;
+		}
+
+		{
+			JobQueue& rQueue = *gQueues[tQueueIndex];
+			std::lock_guard<std::mutex> lock(rQueue.mutex);
+
+			if (!rQueue.jobs.empty())
+			{
+				_rJob = rQueue.jobs.back();
+				rQueue.jobs.pop_back();
+				--gQueuedJobCount;
+
+				return true;
+			}
+		}
+
+		u32 queueCount = u32(gQueues.size());
+		for (u32 queueOffset = 1u; queueOffset < queueCount; ++queueOffset)
+		{
+			JobQueue& rVictimQueue = *gQueues[(tQueueIndex + queueOffset) % queueCount];
+			std::lock_guard<std::mutex> lock(rVictimQueue.mutex);
+
+			if (!rVictimQueue.jobs.empty())
+			{
+				_rJob = rVictimQueue.jobs.front();
+				rVictimQueue.jobs.pop_front();
+				--gQueuedJobCount;
+
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	static void executeJob(
+		Job& _rJob)
+	{
+		(*_rJob.pCallback)(_rJob.index);
+		--(*_rJob.pPendingCount);
+	}
+
+	static void workerLoop(
+		u32 _queueIndex)
+	{
+		EASY_THREAD("JobWorker");
+
+		tQueueIndex = _queueIndex;
+
+		while (gbRunning)
+		{
+			Job job;
+			if (tryPopJob(job))
+			{
+				executeJob(job);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(gWakeMutex);
+			gWakeCondition.wait(lock, []()
+				{
+					return !gbRunning || gQueuedJobCount > 0u;
+				});
+		}
+	}
+
+	void initialize(
+		u32 _workerCount)
+	{
+		assert(!gbRunning);
+
+		if (_workerCount == 0u)
+		{
+			u32 hardwareThreadCount = std::thread::hardware_concurrency();
+			_workerCount = hardwareThreadCount > 1u ? hardwareThreadCount - 1u : 0u;
+		}
+
+		gbRunning = true;
+
+		gQueues.resize(_workerCount + 1u);
+		for (std::unique_ptr<JobQueue>& rQueue : gQueues)
+		{
+			rQueue = std::make_unique<JobQueue>();
+		}
+
+		gWorkers.reserve(_workerCount);
+		for (u32 workerIndex = 0u; workerIndex < _workerCount; ++workerIndex)
+		{
+			gWorkers.emplace_back(workerLoop, workerIndex + 1u);
+		}
+	}
+
+	void terminate()
+	{
+		{
+			std::lock_guard<std::mutex> lock(gWakeMutex);
+			gbRunning = false;
+		}
+
+		gWakeCondition.notify_all();
+
+		for (std::thread& rWorker : gWorkers)
+		{
+			rWorker.join();
+		}
+
+		gWorkers.clear();
+		gQueues.clear();
+	}
+
+	u32 getThreadCount()
+	{
+		return u32(gWorkers.size()) + 1u;
+	}
+
+	void parallelFor(
+		u32 _count,
+		LAMBDA(u32) _callback)
+	{
+		if (_count == 0u)
+		{
+			return;
+		}
+
+		// Run inline when there is nobody to share the work with.
+		if (gWorkers.empty() || _count == 1u)
+		{
+			for (u32 index = 0u; index < _count; ++index)
+			{
+				_callback(index);
+			}
+
+			return;
+		}
+
+		std::atomic<u32> pendingCount = _count;
+
+		{
+			JobQueue& rQueue = *gQueues[tQueueIndex];
+			std::lock_guard<std::mutex> lock(rQueue.mutex);
+
+			// Pushed in reverse, so the owner pops them in index order and thieves take the tail.
+			for (u32 index = _count; index > 0u; --index)
+			{
+				rQueue.jobs.push_back({
+					.pCallback = &_callback,
+					.index = index - 1u,
+					.pPendingCount = &pendingCount });
+			}
+
+			gQueuedJobCount += _count;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(gWakeMutex);
+		}
+
+		gWakeCondition.notify_all();
+
+		while (pendingCount > 0u)
+		{
+			Job job;
+			if (tryPopJob(job))
+			{
+				executeJob(job);
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+// Work stealing job system. Every worker owns a job queue, pops its own jobs from the back
+// and steals from the front of other queues when it runs dry. Threads waiting on a job batch
+// keep executing jobs instead of blocking, so batches can be nested safely.
+
+namespace jobs
+{
+	void initialize(
+		u32 _workerCount = 0u);
+
+	void terminate();
+
+	// Number of threads executing jobs, including the calling thread.
+	u32 getThreadCount();
+
+	// Calls _callback for every index in [0, _count) and returns once all of them are done.
+	void parallelFor(
+		u32 _count,
+		LAMBDA(u32) _callback);
+}
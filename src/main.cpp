@@ -12,9 +12,13 @@
 #include "camera.h"
 #include "shaders/shader_constants.h"
 #include "geometry.h"
+#include "geometry_streaming.h"
 #include "draw.h"
+#include "impostor.h"
 #include "gui.h"
 #include "gpu_profiler.h"
+#include "job_system.h"
+#include "scratch_arena.h"
 #include "utils.h"
 
 #include <string.h>
@@ -27,6 +31,20 @@ const bool kbEnableValidationLayers = false;
 #endif // DEBUG_
 
 const bool kbEnableMeshShadingPipeline = true;
+const bool kbEnableParallelMeshLods = true;
+const bool kbEnableClusterHierarchy = true;
+const bool kbEnableGeometryStreaming = false;
+
+// Streamed meshes are never split, since streaming works with a single mesh per cache file.
+const u32 kMeshChunkTriangleCount = 32'768u;
+const bool kbEnableLodVertexCompaction = true;
+const bool kbEnableSloppyLods = true;
+const bool kbEnablePositionOnlyLods = false;
+
+// Impostors are baked from the whole geometry, so they are unavailable with streaming.
+const bool kbEnableImpostors = true;
+
+const u64 kGeometryStreamingPoolByteSize = 256ull << 20;
 
 const u32 kPreferredSwapchainImageCount = 2u;
 const bool kbEnableVSync = false;
@@ -85,6 +103,9 @@ i32 main(
 		return 1;
 	}
 
+	jobs::initialize();
+	scratch::initialize();
+
 	GLFWwindow* pWindow = createWindow({
 		.width = kWindowWidth,
 		.height = kWindowHeight,
@@ -172,6 +193,10 @@ i32 main(
 		.boostMoveSpeed = 3.0f,
 		.sensitivity = 100.0f };
 
+	Shader cullInstanceNodesShader = createShader(device, {
+		.pPath = "shaders/cull_instance_nodes.comp.spv",
+		.pEntry = "main" });
+
 	Shader generateDrawsShader = createShader(device, {
 		.pPath = "shaders/generate_draws.comp.spv",
 		.pEntry = "main" });
@@ -198,6 +223,15 @@ i32 main(
 		.pPath = "shaders/hzb_downsample.comp.spv",
 		.pEntry = "main" });
 
+	Shader impostorVertShader = createShader(device, {
+		.pPath = "shaders/impostor.vert.spv",
+		.pEntry = "main" });
+
+	Shader impostorFragShader = createShader(device, {
+		.pPath = "shaders/impostor.frag.spv",
+		.pEntry = "main" });
+
+	Pipeline cullInstanceNodesPipeline = createComputePipeline(device, cullInstanceNodesShader);
 	Pipeline generateDrawsPipeline = createComputePipeline(device, generateDrawsShader);
 
 	Pipeline geometryPipeline = createGraphicsPipeline(device, {
@@ -209,7 +243,8 @@ i32 main(
 			.depthStencilFormat = { depthTexture.format }},
 		.rasterization = {
 			.cullMode = VK_CULL_MODE_BACK_BIT,
-			.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE },
+			.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+			.bDynamicFrontFace = true },
 		.depthStencil = {
 			.bDepthTestEnable = true,
 			.bDepthWriteEnable = true,
@@ -233,6 +268,22 @@ i32 main(
 
 	Pipeline hzbDownsamplePipeline = createComputePipeline(device, hzbDownsampleShader);
 
+	// Impostor quads face their baked frame instead of the camera, so they can be seen from behind.
+	Pipeline impostorPipeline = createGraphicsPipeline(device, {
+		.shaders = { impostorVertShader, impostorFragShader },
+		.attachmentLayout = {
+			.colorAttachments = { {
+				.format = swapchain.format,
+				.bBlendEnable = true } },
+			.depthStencilFormat = { depthTexture.format }},
+		.rasterization = {
+			.cullMode = VK_CULL_MODE_NONE },
+		.depthStencil = {
+			.bDepthTestEnable = true,
+			.bDepthWriteEnable = true,
+			.depthCompareOp = VK_COMPARE_OP_GREATER } });
+
+	destroyShader(device, cullInstanceNodesShader);
 	destroyShader(device, generateDrawsShader);
 
 	if (device.bMeshShadingPipelineAllowed)
@@ -244,9 +295,31 @@ i32 main(
 	destroyShader(device, fragShader);
 	destroyShader(device, vertShader);
 	destroyShader(device, hzbDownsampleShader);
+	destroyShader(device, impostorFragShader);
+	destroyShader(device, impostorVertShader);
+
+	bool bGeometryStreaming = kbEnableGeometryStreaming && device.bMeshShadingPipelineAllowed;
+
+	MeshProcessingDesc meshProcessingDesc = {
+		.bParallelLods = kbEnableParallelMeshLods,
+		.bClusterHierarchy = kbEnableClusterHierarchy,
+		.bStreamingPages = bGeometryStreaming,
+		.chunkTriangleCount = bGeometryStreaming ? 0u : kMeshChunkTriangleCount,
+		.bCompactLodVertices = kbEnableLodVertexCompaction && !bGeometryStreaming,
+		.bSloppyLods = kbEnableSloppyLods,
+		.bPositionOnlyLods = kbEnablePositionOnlyLods };
+
+	GeometryStreamingBuffers geometryStreamingBuffers{};
 
-	GeometryBuffers geometryBuffers = createGeometryBuffers(device, meshCount, _argv);
-	DrawBuffers drawBuffers = createDrawBuffers(device, meshCount, kMaxDrawCount, kSpawnCubeSize);
+	GeometryBuffers geometryBuffers = bGeometryStreaming ?
+		streaming::initialize(device, meshCount, _argv, meshProcessingDesc, kGeometryStreamingPoolByteSize, geometryStreamingBuffers) :
+		createGeometryBuffers(device, meshCount, _argv, meshProcessingDesc);
+
+	DrawBuffers drawBuffers = createDrawBuffers(device, geometryBuffers.sourceMeshOffsets,
+		geometryBuffers.sourceInstanceOffsets, geometryBuffers.instances, geometryBuffers.meshes, kMaxDrawCount, kSpawnCubeSize);
+
+	bool bImpostors = kbEnableImpostors && !bGeometryStreaming;
+	Texture impostorAtlas = bImpostors ? createImpostorAtlas(device, geometryBuffers) : Texture();
 
 	std::array<VkCommandBuffer, kMaxFramesInFlightCount> commandBuffers;
 	for (VkCommandBuffer& rCommandBuffer : commandBuffers)
@@ -269,15 +342,22 @@ i32 main(
 		v4 frustumPlanes[kFrustumPlaneCount];
 		v3 cameraPosition;
 		u32 maxDrawCount;
-		f32 lodTransitionBase;
-		f32 lodTransitionStep;
 		i32 forcedLod;
 		u32 hzbSize;
+		f32 lodErrorThreshold;
 		i8 bPrepass;
 		i8 bEnableMeshFrustumCulling;
 		i8 bEnableMeshOcclusionCulling;
 		i8 bEnableMeshletConeCulling;
 		i8 bEnableMeshletFrustumCulling;
+		i8 bEnableClusterLod;
+		i8 bEnableGeometryStreaming;
+		i8 bEnableBoxCulling;
+		i8 bEnableShortIndices;
+		i8 bEnableImpostors;
+		i8 occlusionRetestSlice;
+		i8 bEnableMirroredDrawBatches;
+		f32 impostorSizeThreshold;
 	} perFrameData = {};
 
 	VkPhysicalDeviceProperties physicalDeviceProperties;
@@ -298,6 +378,55 @@ i32 main(
 		settings.bMeshShadingPipelineSupported =
 		device.bMeshShadingPipelineAllowed;
 
+	settings.bImpostorsEnabled = settings.bImpostorsSupported = bImpostors;
+
+	// Clusters aren't streamed, so streamed meshes are always drawn with their LODs.
+	settings.bGeometryStreamingEnabled = bGeometryStreaming;
+	settings.bClusterLodEnabled = settings.bClusterLodEnabled && !bGeometryStreaming;
+
+	u32 frameIndex = 0;
+	u64 frameNumber = 0ull;
+
+	// Prepass lists visible leaf nodes of the instance hierarchy, which its draw generation gets dispatched over,
+	// while the second pass leaves the draws of newly visible leaf nodes pending.
+	auto cullInstanceNodesPass = [&](
+		VkCommandBuffer _commandBuffer,
+		bool _bPrepass)
+	{
+		GPU_BLOCK(_commandBuffer, _bPrepass ? "CullInstanceNodesPrepass" : "CullInstanceNodesPass");
+
+		if (_bPrepass)
+		{
+			VkDispatchIndirectCommand dispatchCommand = { 0u, 1u, 1u };
+
+			updateBuffer(_commandBuffer, device, drawBuffers.visibleInstanceNodesBuffer, sizeof(dispatchCommand), &dispatchCommand,
+				VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+				VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+		}
+
+		perFrameData.bPrepass = _bPrepass ? 1 : 0;
+
+		executePass(_commandBuffer, {
+			.pipeline = cullInstanceNodesPipeline,
+			.bindings = {
+				Binding(drawBuffers.instanceNodesBuffer),
+				Binding(drawBuffers.instanceNodeVisibilityBuffer),
+				Binding(drawBuffers.visibleInstanceNodesBuffer),
+				Binding(hzb, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+				Binding(drawBuffers.pendingDrawsBuffer) },
+			.pushConstants = {
+				.byteSize = sizeof(perFrameData),
+				.pData = &perFrameData } },
+				[&]()
+			{
+				vkCmdDispatch(_commandBuffer, drawBuffers.topInstanceNodeCount, 1u, 1u);
+			});
+
+		bufferBarrier(_commandBuffer, device, _bPrepass ? drawBuffers.visibleInstanceNodesBuffer : drawBuffers.pendingDrawsBuffer,
+			VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	};
+
 	auto generateDrawsPass = [&](
 		VkCommandBuffer _commandBuffer,
 		bool _bPrepass)
@@ -305,6 +434,8 @@ i32 main(
 		GPU_BLOCK(_commandBuffer, _bPrepass ? "GenerateDrawsPrepass" : "GenerateDrawsPass");
 
 		perFrameData.bPrepass = _bPrepass ? 1 : 0;
+		perFrameData.bEnableShortIndices = bMeshShadingPipelineEnabled ? 0 : 1;
+		perFrameData.bEnableMirroredDrawBatches = bMeshShadingPipelineEnabled ? 0 : 1;
 
 		executePass(_commandBuffer, {
 			.pipeline = generateDrawsPipeline,
@@ -314,13 +445,23 @@ i32 main(
 				Binding(drawBuffers.drawCommandsBuffer),
 				Binding(drawBuffers.drawCountBuffer),
 				Binding(drawBuffers.visibilityBuffer),
-				Binding(hzb, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) },
+				Binding(hzb, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+				// Meshes buffer is bound as a placeholder, since streaming bindings are unused without streaming.
+				Binding(bGeometryStreaming ? geometryStreamingBuffers.feedbackBuffers[frameIndex] : geometryBuffers.meshesBuffer),
+				Binding(bGeometryStreaming ? geometryStreamingBuffers.lodResidencyBuffer : geometryBuffers.meshesBuffer),
+				Binding(drawBuffers.impostorDrawsBuffer),
+				// HZB is bound as a placeholder, since the atlas is never sampled without impostors.
+				Binding(bImpostors ? impostorAtlas : hzb, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL),
+				Binding(drawBuffers.visibleInstanceNodesBuffer),
+				Binding(drawBuffers.pendingDrawsBuffer),
+				Binding(drawBuffers.drawBoundsBuffer) },
 			.pushConstants = {
 				.byteSize = sizeof(perFrameData),
 				.pData = &perFrameData } },
 				[&]()
 			{
-				vkCmdDispatch(_commandBuffer, divideRoundingUp(kMaxDrawCount, kShaderGroupSizeNV), 1u, 1u);
+				vkCmdDispatchIndirect(_commandBuffer, _bPrepass ?
+					drawBuffers.visibleInstanceNodesBuffer.resource : drawBuffers.pendingDrawsBuffer.resource, 0u);
 			});
 	};
 
@@ -358,11 +499,14 @@ i32 main(
 					Binding(geometryBuffers.meshesBuffer),
 					Binding(geometryBuffers.meshletVerticesBuffer),
 					Binding(geometryBuffers.meshletTrianglesBuffer),
-					Binding(geometryBuffers.vertexBuffer) }) :
+					Binding(geometryBuffers.vertexBuffer),
+					Binding(geometryBuffers.clusterBuffer),
+					Binding(bGeometryStreaming ? geometryStreamingBuffers.pageTableBuffer : geometryBuffers.meshesBuffer) }) :
 				Bindings({
 					Binding(geometryBuffers.vertexBuffer),
 					Binding(drawBuffers.drawsBuffer),
-					Binding(drawBuffers.drawCommandsBuffer) }),
+					Binding(drawBuffers.drawCommandsBuffer),
+					Binding(geometryBuffers.meshesBuffer) }),
 			.pushConstants = {
 				.byteSize = sizeof(perFrameData),
 				.pData = &perFrameData } },
@@ -371,18 +515,87 @@ i32 main(
 				if (_bMeshShadingPipelineEnabled)
 				{
 					vkCmdDrawMeshTasksIndirectCountNV(_commandBuffer, drawBuffers.drawCommandsBuffer.resource,
-						offsetof(DrawCommand, taskCount), drawBuffers.drawCountBuffer.resource, 0u, kMaxDrawCount, sizeof(DrawCommand));
+						offsetof(DrawCommand, taskCount), drawBuffers.drawCountBuffer.resource, 0u, drawBuffers.drawCount, sizeof(DrawCommand));
 				}
 				else
 				{
-					vkCmdBindIndexBuffer(_commandBuffer, geometryBuffers.indexBuffer.resource, 0u, VK_INDEX_TYPE_UINT32);
+					// Mirrored transforms turn the winding of their triangles around, so their batches flip the front face.
+					for (u32 drawBatch = 0; drawBatch < kDrawBatchCount; ++drawBatch)
+					{
+						bool bShortIndexBatch = (drawBatch & kShortIndexDrawBatch) != 0u;
+						bool bMirroredBatch = (drawBatch & kMirroredDrawBatch) != 0u;
+
+						vkCmdSetFrontFace(_commandBuffer, bMirroredBatch ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE);
+
+						vkCmdBindIndexBuffer(_commandBuffer, bShortIndexBatch ? geometryBuffers.shortIndexBuffer.resource : geometryBuffers.indexBuffer.resource,
+							0u, bShortIndexBatch ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32);
 
-					vkCmdDrawIndexedIndirectCount(_commandBuffer, drawBuffers.drawCommandsBuffer.resource,
-						offsetof(DrawCommand, indexCount), drawBuffers.drawCountBuffer.resource, 0u, kMaxDrawCount, sizeof(DrawCommand));
+						vkCmdDrawIndexedIndirectCount(_commandBuffer, drawBuffers.drawCommandsBuffer.resource,
+							drawBatch * drawBuffers.drawCount * sizeof(DrawCommand) + offsetof(DrawCommand, indexCount),
+							drawBuffers.drawCountBuffer.resource, drawBatch * sizeof(u32), drawBuffers.drawCount, sizeof(DrawCommand));
+					}
 				}
 			});
 	};
 
+	auto impostorPass = [&](
+		VkCommandBuffer _commandBuffer,
+		u32 _currentSwapchainImageIndex,
+		bool _bPrepass)
+	{
+		GPU_BLOCK(_commandBuffer, _bPrepass ? "ImpostorPrepass" : "ImpostorPass");
+
+		perFrameData.bPrepass = _bPrepass ? 1 : 0;
+
+		executePass(_commandBuffer, {
+			.pipeline = impostorPipeline,
+			.viewport = {
+				.offset = { 0.0f, 0.0f },
+				.extent = { swapchain.extent.width, swapchain.extent.height }},
+			.scissor = {
+				.offset = { 0, 0 },
+				.extent = { swapchain.extent.width, swapchain.extent.height }},
+			.colorAttachments = {{
+				.texture = swapchain.textures[_currentSwapchainImageIndex],
+				.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD }},
+			.depthStencilAttachment = {
+				.texture = depthTexture,
+				.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD },
+			.bindings = {
+				Binding(drawBuffers.impostorDrawsBuffer),
+				Binding(drawBuffers.drawsBuffer),
+				Binding(geometryBuffers.meshesBuffer),
+				Binding(impostorAtlas, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) },
+			.pushConstants = {
+				.byteSize = sizeof(perFrameData),
+				.pData = &perFrameData } },
+				[&]()
+			{
+				vkCmdDrawIndirect(_commandBuffer, drawBuffers.impostorDrawsBuffer.resource, 0u, 1u, sizeof(ImpostorDrawCommand));
+			});
+	};
+
+	// Impostor instance count restarts for every culling pass, while the rest of its draw command stays the same.
+	auto resetImpostorDraws = [&](
+		VkCommandBuffer _commandBuffer)
+	{
+		ImpostorDrawCommand impostorDrawCommand{};
+
+		updateBuffer(_commandBuffer, device, drawBuffers.impostorDrawsBuffer, sizeof(impostorDrawCommand), &impostorDrawCommand,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	};
+
+	auto resetPendingDraws = [&](
+		VkCommandBuffer _commandBuffer)
+	{
+		PendingDrawsCommand pendingDrawsCommand{};
+
+		updateBuffer(_commandBuffer, device, drawBuffers.pendingDrawsBuffer, sizeof(pendingDrawsCommand), &pendingDrawsCommand,
+			VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+			VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+	};
+
 	auto buildHzbPass = [&](
 		VkCommandBuffer _commandBuffer)
 	{
@@ -415,8 +628,6 @@ i32 main(
 		}
 	};
 
-	u32 frameIndex = 0;
-
 	while (!glfwWindowShouldClose(pWindow))
 	{
 		EASY_BLOCK("Frame");
@@ -473,15 +684,26 @@ i32 main(
 
 			perFrameData.view = camera.view;
 			perFrameData.projection = camera.projection;
-			perFrameData.maxDrawCount = kMaxDrawCount;
-			perFrameData.lodTransitionBase = 4.0f;
-			perFrameData.lodTransitionStep = 1.25f;
+			perFrameData.maxDrawCount = drawBuffers.drawCount;
 			perFrameData.forcedLod = settings.bForceMeshLodEnabled ? settings.forcedLod : -1;
 			perFrameData.hzbSize = hzbSize;
 			perFrameData.bEnableMeshFrustumCulling = settings.bMeshFrustumCullingEnabled ? 1u : 0u;
 			perFrameData.bEnableMeshOcclusionCulling = settings.bMeshOcclusionCullingEnabled ? 1u : 0u;
 			perFrameData.bEnableMeshletConeCulling = settings.bMeshletConeCullingEnabled ? 1u : 0u;
 			perFrameData.bEnableMeshletFrustumCulling = settings.bMeshletFrustumCullingEnabled ? 1u : 0u;
+			perFrameData.bEnableClusterLod = settings.bClusterLodEnabled ? 1u : 0u;
+			perFrameData.bEnableGeometryStreaming = bGeometryStreaming ? 1u : 0u;
+			perFrameData.bEnableBoxCulling = settings.bBoxCullingEnabled ? 1u : 0u;
+			perFrameData.bEnableImpostors = settings.bImpostorsEnabled ? 1u : 0u;
+			perFrameData.occlusionRetestSlice = i8(frameNumber % kOcclusionRetestSliceCount);
+
+			// Pixel error threshold converted to a world space error at unit distance, shared by mesh LODs and clusters.
+			perFrameData.lodErrorThreshold = 2.0f * settings.lodPixelError /
+				(camera.projection[1][1] * f32(swapchain.extent.height));
+
+			// Same conversion for the bounding sphere radius in pixels, under which meshes switch to impostors.
+			perFrameData.impostorSizeThreshold = 2.0f * settings.impostorPixelRadius /
+				(camera.projection[1][1] * f32(swapchain.extent.height));
 
 			if (!settings.bFreezeCameraEnabled)
 			{
@@ -500,6 +722,11 @@ i32 main(
 
 			gpu::profiler::beginFrame(commandBuffer);
 
+			if (bGeometryStreaming)
+			{
+				streaming::update(commandBuffer, device, frameIndex);
+			}
+
 			{
 				GPU_STATS(commandBuffer, "Frame");
 
@@ -517,8 +744,16 @@ i32 main(
 						VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
 						VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
+					resetImpostorDraws(commandBuffer);
+					resetPendingDraws(commandBuffer);
+
+					cullInstanceNodesPass(commandBuffer, /*bPrepass*/ true);
 					generateDrawsPass(commandBuffer, /*bPrepass*/ true);
 
+					bufferBarrier(commandBuffer, device, drawBuffers.pendingDrawsBuffer,
+						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+
 					bufferBarrier(commandBuffer, device, drawBuffers.drawCountBuffer,
 						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
 						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
@@ -527,7 +762,16 @@ i32 main(
 						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
 						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
 
+					bufferBarrier(commandBuffer, device, drawBuffers.impostorDrawsBuffer,
+						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+
 					geometryPass(commandBuffer, currentSwapchainImageIndex, bMeshShadingPipelineEnabled, /*bPrepass*/ true);
+
+					if (bImpostors)
+					{
+						impostorPass(commandBuffer, currentSwapchainImageIndex, /*bPrepass*/ true);
+					}
 				}
 
 				{
@@ -539,7 +783,7 @@ i32 main(
 					textureBarrier(commandBuffer, depthTexture,
 						VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 						VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
-						VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,	VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
+						VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
 					buildHzbPass(commandBuffer);
 
@@ -558,8 +802,18 @@ i32 main(
 						VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_ACCESS_SHADER_WRITE_BIT,
 						VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT);
 
+					resetImpostorDraws(commandBuffer);
+
+					cullInstanceNodesPass(commandBuffer, /*bPrepass*/ false);
 					generateDrawsPass(commandBuffer, /*bPrepass*/ false);
 
+					if (bGeometryStreaming)
+					{
+						bufferBarrier(commandBuffer, device, geometryStreamingBuffers.feedbackBuffers[frameIndex],
+							VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_HOST_READ_BIT,
+							VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT);
+					}
+
 					bufferBarrier(commandBuffer, device, drawBuffers.drawCountBuffer,
 						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
 						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
@@ -568,7 +822,16 @@ i32 main(
 						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT,
 						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT);
 
+					bufferBarrier(commandBuffer, device, drawBuffers.impostorDrawsBuffer,
+						VK_ACCESS_SHADER_WRITE_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+						VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT);
+
 					geometryPass(commandBuffer, currentSwapchainImageIndex, bMeshShadingPipelineEnabled, /*bPrepass*/ false);
+
+					if (bImpostors)
+					{
+						impostorPass(commandBuffer, currentSwapchainImageIndex, /*bPrepass*/ false);
+					}
 				}
 
 				gui::drawFrame(commandBuffer, frameIndex, swapchain.textures[currentSwapchainImageIndex]);
@@ -588,7 +851,16 @@ i32 main(
 
 		gui::updateGpuPerformanceState(physicalDeviceProperties.limits, settings);
 
+		if (bGeometryStreaming)
+		{
+			GeometryStreamingStats streamingStats = streaming::getStats();
+			settings.streamingResidentPageCount = streamingStats.residentPageCount;
+			settings.streamingPoolPageCount = streamingStats.poolPageCount;
+			settings.streamingPendingLodCount = streamingStats.pendingLodCount;
+		}
+
 		frameIndex = (frameIndex + 1) % kMaxFramesInFlightCount;
+		++frameNumber;
 	}
 
 	{
@@ -614,26 +886,53 @@ i32 main(
 			destroyTextureView(device, rHzbMip);
 		}
 
+		if (bGeometryStreaming)
+		{
+			streaming::terminate(device);
+
+			destroyBuffer(device, geometryStreamingBuffers.pageTableBuffer);
+			destroyBuffer(device, geometryStreamingBuffers.lodResidencyBuffer);
+
+			for (Buffer& rFeedbackBuffer : geometryStreamingBuffers.feedbackBuffers)
+			{
+				destroyBuffer(device, rFeedbackBuffer);
+			}
+		}
+
 		{
 			if (device.bMeshShadingPipelineAllowed)
 			{
 				destroyBuffer(device, geometryBuffers.meshletBuffer);
 				destroyBuffer(device, geometryBuffers.meshletVerticesBuffer);
 				destroyBuffer(device, geometryBuffers.meshletTrianglesBuffer);
+				destroyBuffer(device, geometryBuffers.clusterBuffer);
 			}
 
 			destroyBuffer(device, geometryBuffers.vertexBuffer);
 			destroyBuffer(device, geometryBuffers.indexBuffer);
+			destroyBuffer(device, geometryBuffers.shortIndexBuffer);
 			destroyBuffer(device, geometryBuffers.meshesBuffer);
 		}
 
 		{
 			destroyBuffer(device, drawBuffers.drawsBuffer);
+			destroyBuffer(device, drawBuffers.drawBoundsBuffer);
 			destroyBuffer(device, drawBuffers.drawCommandsBuffer);
 			destroyBuffer(device, drawBuffers.drawCountBuffer);
 			destroyBuffer(device, drawBuffers.visibilityBuffer);
+			destroyBuffer(device, drawBuffers.impostorDrawsBuffer);
+			destroyBuffer(device, drawBuffers.instanceNodesBuffer);
+			destroyBuffer(device, drawBuffers.instanceNodeVisibilityBuffer);
+			destroyBuffer(device, drawBuffers.visibleInstanceNodesBuffer);
+			destroyBuffer(device, drawBuffers.pendingDrawsBuffer);
 		}
 
+		if (bImpostors)
+		{
+			destroyTexture(device, impostorAtlas);
+		}
+
+		destroyPipeline(device, impostorPipeline);
 		destroyPipeline(device, hzbDownsamplePipeline);
 
 		if (device.bMeshShadingPipelineAllowed)
@@ -643,11 +942,14 @@ i32 main(
 
 		destroyPipeline(device, geometryPipeline);
 		destroyPipeline(device, generateDrawsPipeline);
+		destroyPipeline(device, cullInstanceNodesPipeline);
 
 		destroyTexture(device, depthTexture);
 		destroySwapchain(device, swapchain);
 		destroyDevice(device);
 		destroyWindow(pWindow);
+
+		jobs::terminate();
 	}
 
 	{
@@ -0,0 +1,1029 @@
+#include "core/device.h"
+#include "core/buffer.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "mesh_import.h"
+#include "gltf_import.h"
+#include "cluster_hierarchy.h"
+#include "quantization.h"
+#include "bounds.h"
+#include "job_system.h"
+#include "scratch_arena.h"
+#include "utils.h"
+
+#include <fast_obj.h>
+#include <meshoptimizer.h>
+#include <CRC.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+
+// Cones come from meshoptimizer, while spheres are computed separately, since they are much tighter.
+static Meshlet buildMeshlet(
+	meshopt_Meshlet _meshlet,
+	meshopt_Bounds _bounds,
+	BoundingSphere _sphere)
+{
+	Meshlet meshlet{};
+
+	meshlet.vertexOffset = _meshlet.vertex_offset;
+	meshlet.triangleOffset = _meshlet.triangle_offset;
+	meshlet.vertexCount = _meshlet.vertex_count;
+	meshlet.triangleCount = _meshlet.triangle_count;
+	
+	meshlet.center[0] = _sphere.center.x;
+	meshlet.center[1] = _sphere.center.y;
+	meshlet.center[2] = _sphere.center.z;
+	meshlet.radius = _sphere.radius;
+
+	meshlet.coneAxis[0] = _bounds.cone_axis_s8[0];
+	meshlet.coneAxis[1] = _bounds.cone_axis_s8[1];
+	meshlet.coneAxis[2] = _bounds.cone_axis_s8[2];
+	meshlet.coneCutoff = _bounds.cone_cutoff_s8;
+
+	return meshlet;
+}
+
+// Triangles per meshlet build job, when meshlets of a single LOD are built in parallel.
+const u32 kMeshletChunkTriangleCount = 16384u;
+
+// Meshlets per bounds calculation job.
+const u32 kMeshletBoundsBatchSize = 512u;
+
+struct LodMeshlets
+{
+	std::vector<Meshlet> meshlets;
+	std::vector<u32> meshletVertices;
+	std::vector<u8> meshletTriangles;
+};
+
+struct MeshletChunk
+{
+	std::vector<meshopt_Meshlet> meshlets;
+	std::vector<u32> meshletVertices;
+	std::vector<u8> meshletTriangles;
+};
+
+static void buildMeshletChunk(
+	MeshletChunk& _rChunk,
+	const u32* _pIndices,
+	size_t _indexCount,
+	std::vector<RawVertex>& _rVertices,
+	f32 _coneWeight)
+{
+	// Worst case sized buffers only live in scratch memory, while the chunk gets exactly sized copies.
+	size_t maxMeshlets = meshopt_buildMeshletsBound(_indexCount, kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet);
+	ScratchVector<meshopt_Meshlet> meshlets(maxMeshlets);
+	ScratchVector<u32> meshletVertices(maxMeshlets * kMaxVerticesPerMeshlet);
+	ScratchVector<u8> meshletTriangles(maxMeshlets * kMaxTrianglesPerMeshlet * 3);
+
+	// Cone weight can be tuned per mesh set with vulkanizer_meshlet_benchmark, which simulates the culling it affects.
+	size_t meshletCount = meshopt_buildMeshlets(meshlets.data(), meshletVertices.data(), meshletTriangles.data(), _pIndices, _indexCount,
+		&_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex), kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet, _coneWeight);
+
+	meshopt_Meshlet& rLastMeshlet = meshlets[meshletCount - 1];
+
+	_rChunk.meshlets.assign(meshlets.begin(), meshlets.begin() + meshletCount);
+	_rChunk.meshletVertices.assign(meshletVertices.begin(),
+		meshletVertices.begin() + rLastMeshlet.vertex_offset + size_t(rLastMeshlet.vertex_count));
+	_rChunk.meshletTriangles.assign(meshletTriangles.begin(),
+		meshletTriangles.begin() + rLastMeshlet.triangle_offset + ((size_t(rLastMeshlet.triangle_count) * 3 + 3) & ~3));
+}
+
+static void buildLodMeshlets(
+	LodMeshlets& _rLodMeshlets,
+	std::vector<u32>& _rIndices,
+	std::vector<RawVertex>& _rVertices,
+	MeshProcessingDesc _processingDesc)
+{
+	// Parallel builds split the index buffer into contiguous ranges, which are spatially coherent after
+	// vertex cache optimization. Meshlets never cross range borders, so results differ slightly from a serial build.
+	u32 triangleCount = u32(_rIndices.size() / 3);
+	u32 chunkCount = _processingDesc.bParallelLods ? divideRoundingUp(triangleCount, kMeshletChunkTriangleCount) : 1u;
+
+	std::vector<MeshletChunk> chunks(chunkCount);
+
+	jobs::parallelFor(chunkCount, [&](u32 _chunkIndex)
+		{
+			u32 firstTriangle = _chunkIndex * kMeshletChunkTriangleCount;
+			u32 chunkTriangleCount = chunkCount == 1u ? triangleCount :
+				glm::min(kMeshletChunkTriangleCount, triangleCount - firstTriangle);
+
+			buildMeshletChunk(chunks[_chunkIndex], &_rIndices[3 * size_t(firstTriangle)], 3 * size_t(chunkTriangleCount),
+				_rVertices, _processingDesc.meshletConeWeight);
+		});
+
+	// Counting pass sizes the merged streams up front, instead of growing them chunk by chunk.
+	size_t meshletCount = 0u;
+	size_t meshletVertexCount = 0u;
+	size_t meshletTriangleCount = 0u;
+
+	for (MeshletChunk& rChunk : chunks)
+	{
+		meshletCount += rChunk.meshlets.size();
+		meshletVertexCount += rChunk.meshletVertices.size();
+		meshletTriangleCount += rChunk.meshletTriangles.size();
+	}
+
+	ScratchVector<meshopt_Meshlet> meshlets;
+	meshlets.reserve(meshletCount);
+	_rLodMeshlets.meshletVertices.reserve(meshletVertexCount);
+	_rLodMeshlets.meshletTriangles.reserve(meshletTriangleCount);
+
+	for (MeshletChunk& rChunk : chunks)
+	{
+		u32 meshletVerticesOffset = u32(_rLodMeshlets.meshletVertices.size());
+		u32 meshletTrianglesOffset = u32(_rLodMeshlets.meshletTriangles.size());
+
+		for (meshopt_Meshlet& rMeshlet : rChunk.meshlets)
+		{
+			rMeshlet.vertex_offset += meshletVerticesOffset;
+			rMeshlet.triangle_offset += meshletTrianglesOffset;
+		}
+
+		meshlets.insert(meshlets.end(), rChunk.meshlets.begin(), rChunk.meshlets.end());
+		_rLodMeshlets.meshletVertices.insert(_rLodMeshlets.meshletVertices.end(), rChunk.meshletVertices.begin(), rChunk.meshletVertices.end());
+		_rLodMeshlets.meshletTriangles.insert(_rLodMeshlets.meshletTriangles.end(), rChunk.meshletTriangles.begin(), rChunk.meshletTriangles.end());
+	}
+
+	_rLodMeshlets.meshlets.resize(meshlets.size());
+
+	u32 batchCount = divideRoundingUp(u32(meshlets.size()), kMeshletBoundsBatchSize);
+
+	jobs::parallelFor(batchCount, [&](u32 _batchIndex)
+		{
+			u32 firstMeshlet = _batchIndex * kMeshletBoundsBatchSize;
+			u32 lastMeshlet = glm::min(firstMeshlet + kMeshletBoundsBatchSize, u32(meshlets.size()));
+
+			for (u32 meshletIndex = firstMeshlet; meshletIndex < lastMeshlet; ++meshletIndex)
+			{
+				meshopt_Meshlet& rMeshlet = meshlets[meshletIndex];
+				meshopt_Bounds bounds = meshopt_computeMeshletBounds(&_rLodMeshlets.meshletVertices[rMeshlet.vertex_offset],
+					&_rLodMeshlets.meshletTriangles[rMeshlet.triangle_offset], rMeshlet.triangle_count,
+					&_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex));
+
+				BoundingSphere sphere = calculateBoundingSphere(&_rVertices[0].position[0], sizeof(RawVertex),
+					&_rLodMeshlets.meshletVertices[rMeshlet.vertex_offset], rMeshlet.vertex_count);
+
+				_rLodMeshlets.meshlets[meshletIndex] = buildMeshlet(rMeshlet, bounds, sphere);
+			}
+		});
+}
+
+// Boxes are computed from quantized positions, so they bound exactly what gets drawn.
+static void calculateMeshletBoxes(
+	Geometry& _rGeometry,
+	u32 _firstMeshlet,
+	u32 _meshletCount,
+	u32 _vertexOffset)
+{
+	for (u32 meshletIndex = _firstMeshlet; meshletIndex < _firstMeshlet + _meshletCount; ++meshletIndex)
+	{
+		Meshlet& rMeshlet = _rGeometry.meshlets[meshletIndex];
+
+		i16 boxMin[3] = { INT16_MAX, INT16_MAX, INT16_MAX };
+		i16 boxMax[3] = { INT16_MIN, INT16_MIN, INT16_MIN };
+
+		for (u32 vertexIndex = 0u; vertexIndex < rMeshlet.vertexCount; ++vertexIndex)
+		{
+			u32 meshVertex = _rGeometry.meshletVertices[rMeshlet.vertexOffset + vertexIndex];
+			const Vertex& rVertex = _rGeometry.vertices[_vertexOffset + meshVertex];
+
+			for (u32 axis = 0; axis < 3; ++axis)
+			{
+				boxMin[axis] = glm::min(boxMin[axis], rVertex.position[axis]);
+				boxMax[axis] = glm::max(boxMax[axis], rVertex.position[axis]);
+			}
+		}
+
+		memcpy(rMeshlet.boxMin, boxMin, sizeof(boxMin));
+		memcpy(rMeshlet.boxMax, boxMax, sizeof(boxMax));
+	}
+}
+
+template<typename T>
+static void appendPageData(
+	std::vector<u8>& _rPageData,
+	std::vector<T>& _rElements)
+{
+	size_t byteOffset = _rPageData.size();
+	_rPageData.resize(byteOffset + sizeof(T) * _rElements.size());
+
+	if (!_rElements.empty())
+	{
+		memcpy(&_rPageData[byteOffset], _rElements.data(), sizeof(T) * _rElements.size());
+	}
+}
+
+// Pages copy vertices of their meshlets, so any page can be streamed in without the rest of the mesh.
+static void buildGeometryPages(
+	Geometry& _rGeometry,
+	Mesh& _rMesh)
+{
+	for (u32 lodIndex = 0u; lodIndex < _rMesh.lodCount; ++lodIndex)
+	{
+		MeshLod& rLod = _rMesh.lods[lodIndex];
+		rLod.pageOffset = u32(_rGeometry.pages.size());
+		rLod.pageCount = divideRoundingUp(rLod.meshletCount, kStreamingPageMeshletCount);
+
+		for (u32 pageIndex = 0u; pageIndex < rLod.pageCount; ++pageIndex)
+		{
+			u32 firstMeshlet = rLod.meshletOffset + pageIndex * kStreamingPageMeshletCount;
+			u32 meshletCount = glm::min(u32(kStreamingPageMeshletCount), rLod.meshletOffset + rLod.meshletCount - firstMeshlet);
+
+			std::vector<Meshlet> meshlets;
+			std::vector<u32> meshletVertices;
+			std::vector<u8> meshletTriangles;
+			std::vector<Vertex> vertices;
+			std::unordered_map<u32, u32> pageVertices;
+
+			for (u32 meshletIndex = firstMeshlet; meshletIndex < firstMeshlet + meshletCount; ++meshletIndex)
+			{
+				Meshlet meshlet = _rGeometry.meshlets[meshletIndex];
+
+				for (u32 vertexIndex = 0u; vertexIndex < meshlet.vertexCount; ++vertexIndex)
+				{
+					u32 meshVertex = _rGeometry.meshletVertices[meshlet.vertexOffset + vertexIndex];
+					auto [pageVertex, bInserted] = pageVertices.try_emplace(meshVertex, u32(vertices.size()));
+
+					if (bInserted)
+					{
+						vertices.push_back(_rGeometry.vertices[rLod.vertexOffset + meshVertex]);
+					}
+
+					meshletVertices.push_back(pageVertex->second);
+				}
+
+				// Triangle offsets have to stay 4 byte aligned, since shaders read them as packed words.
+				u32 triangleByteCount = (3 * meshlet.triangleCount + 3) & ~3u;
+				meshletTriangles.insert(meshletTriangles.end(),
+					&_rGeometry.meshletTriangles[meshlet.triangleOffset],
+					&_rGeometry.meshletTriangles[meshlet.triangleOffset] + triangleByteCount);
+
+				meshlet.vertexOffset = u32(meshletVertices.size()) - meshlet.vertexCount;
+				meshlet.triangleOffset = u32(meshletTriangles.size()) - triangleByteCount;
+				meshlets.push_back(meshlet);
+			}
+
+			GeometryPage page = {
+				.dataOffset = u32(_rGeometry.pageData.size()),
+				.meshletCount = u32(meshlets.size()),
+				.meshletVertexCount = u32(meshletVertices.size()),
+				.meshletTriangleCount = u32(meshletTriangles.size()),
+				.vertexCount = u32(vertices.size()) };
+
+			appendPageData(_rGeometry.pageData, meshlets);
+			appendPageData(_rGeometry.pageData, meshletVertices);
+			appendPageData(_rGeometry.pageData, meshletTriangles);
+			appendPageData(_rGeometry.pageData, vertices);
+
+			_rGeometry.pages.push_back(page);
+		}
+	}
+}
+
+// Regular simplification stalls when it can't make even half of the requested reduction within its error limit,
+// which is where the topology agnostic sloppy simplification takes over.
+static bool isSimplificationStalled(
+	size_t _sourceIndexCount,
+	size_t _targetIndexCount,
+	size_t _newIndexCount)
+{
+	return 2 * (_sourceIndexCount - _newIndexCount) < _sourceIndexCount - _targetIndexCount;
+}
+
+// Each LOD is simplified from the previous one, so it has to be built serially. Its error is relative to the mesh extents,
+// and accumulated along the chain, which keeps it a bound of the deviation from LOD0.
+static std::vector<std::vector<u32>> buildLodChain(
+	std::vector<u32>& _rIndices,
+	const std::vector<u32>& _rSimplifyIndices,
+	std::vector<RawVertex>& _rVertices,
+	MeshProcessingDesc _processingDesc,
+	u32 _simplifyOptions,
+	bool _bSloppyLods,
+	std::vector<f32>& _rLodErrors)
+{
+	std::vector<std::vector<u32>> lodIndices;
+	lodIndices.push_back(_rIndices);
+	_rLodErrors.assign(1u, 0.0f);
+
+	bool bSloppy = false;
+	f32 sloppyTargetError = _processingDesc.lodTargetError;
+
+	while (lodIndices.size() < kMaxMeshLods)
+	{
+		const std::vector<u32>& rSourceIndices = lodIndices.size() == 1u ? _rSimplifyIndices : lodIndices.back();
+		ScratchVector<u32> indices(rSourceIndices.begin(), rSourceIndices.end());
+
+		size_t targetIndexCount = size_t(indices.size() * _processingDesc.lodIndexRatio);
+		size_t newIndexCount = indices.size();
+		f32 resultError = 0.0f;
+
+		if (!bSloppy)
+		{
+			newIndexCount = meshopt_simplify(indices.data(), indices.data(), indices.size(), &_rVertices[0].position[0], _rVertices.size(),
+				sizeof(RawVertex), targetIndexCount, _processingDesc.lodTargetError, _simplifyOptions, &resultError);
+
+			bSloppy = _bSloppyLods && isSimplificationStalled(indices.size(), targetIndexCount, newIndexCount);
+		}
+
+		// Every sloppy LOD doubles the error limit, so the tail keeps shrinking until the mesh is just a couple of triangles.
+		if (bSloppy)
+		{
+			sloppyTargetError *= 2.0f;
+
+			newIndexCount = meshopt_simplifySloppy(indices.data(), rSourceIndices.data(), rSourceIndices.size(), &_rVertices[0].position[0],
+				_rVertices.size(), sizeof(RawVertex), targetIndexCount, sloppyTargetError, &resultError);
+		}
+
+		if (newIndexCount == 0u || newIndexCount >= lodIndices.back().size())
+		{
+			break;
+		}
+
+		indices.resize(newIndexCount);
+		meshopt_optimizeVertexCache(indices.data(), indices.data(), indices.size(), _rVertices.size());
+
+		lodIndices.emplace_back(indices.begin(), indices.end());
+		_rLodErrors.push_back(_rLodErrors.back() + resultError);
+	}
+
+	return lodIndices;
+}
+
+// Each LOD is simplified directly from LOD0, with the index count target and error limit
+// scaled by its level, so all of them can be built at the same time.
+static std::vector<std::vector<u32>> buildIndependentLods(
+	std::vector<u32>& _rIndices,
+	const std::vector<u32>& _rSimplifyIndices,
+	std::vector<RawVertex>& _rVertices,
+	MeshProcessingDesc _processingDesc,
+	u32 _simplifyOptions,
+	bool _bSloppyLods,
+	std::vector<f32>& _rLodErrors)
+{
+	std::vector<std::vector<u32>> lodIndices(kMaxMeshLods);
+	lodIndices[0] = _rIndices;
+	_rLodErrors.assign(kMaxMeshLods, 0.0f);
+
+	jobs::parallelFor(kMaxMeshLods - 1u, [&](u32 _jobIndex)
+		{
+			u32 lodIndex = _jobIndex + 1u;
+			std::vector<u32>& rIndices = lodIndices[lodIndex];
+
+			size_t targetIndexCount = size_t(_rSimplifyIndices.size() * glm::pow(_processingDesc.lodIndexRatio, f32(lodIndex)));
+			f32 targetError = _processingDesc.lodTargetError * f32(lodIndex);
+
+			ScratchVector<u32> indices(_rSimplifyIndices.size());
+			size_t newIndexCount = meshopt_simplify(indices.data(), _rSimplifyIndices.data(), _rSimplifyIndices.size(), &_rVertices[0].position[0],
+				_rVertices.size(), sizeof(RawVertex), targetIndexCount, targetError, _simplifyOptions, &_rLodErrors[lodIndex]);
+
+			if (_bSloppyLods && isSimplificationStalled(_rSimplifyIndices.size(), targetIndexCount, newIndexCount))
+			{
+				newIndexCount = meshopt_simplifySloppy(indices.data(), _rSimplifyIndices.data(), _rSimplifyIndices.size(), &_rVertices[0].position[0],
+					_rVertices.size(), sizeof(RawVertex), targetIndexCount, targetError * glm::pow(2.0f, f32(lodIndex)), &_rLodErrors[lodIndex]);
+			}
+
+			rIndices.resize(newIndexCount);
+			meshopt_optimizeVertexCache(rIndices.data(), indices.data(), newIndexCount, _rVertices.size());
+		});
+
+	// Same stopping rule as the LOD chain, the first level which doesn't reduce the previous one ends it.
+	u32 lodCount = 1u;
+	while (lodCount < kMaxMeshLods && !lodIndices[lodCount].empty() && lodIndices[lodCount].size() < lodIndices[lodCount - 1].size())
+	{
+		// Levels mix regular and sloppy simplification, so errors are kept monotonic for the LOD selection.
+		_rLodErrors[lodCount] = glm::max(_rLodErrors[lodCount], _rLodErrors[lodCount - 1]);
+		++lodCount;
+	}
+
+	lodIndices.resize(lodCount);
+	_rLodErrors.resize(lodCount);
+
+	return lodIndices;
+}
+
+struct MappedObjFile
+{
+	MappedFile file{};
+	size_t readOffset = 0u;
+};
+
+static void* openMappedObjFile(
+	const char* _pPath,
+	void* _pUserData)
+{
+	MappedObjFile* pFile = new MappedObjFile();
+
+	if (!tryMapFile(_pPath, pFile->file))
+	{
+		delete pFile;
+		return nullptr;
+	}
+
+	return pFile;
+}
+
+static void closeMappedObjFile(
+	void* _pFile,
+	void* _pUserData)
+{
+	MappedObjFile* pFile = (MappedObjFile*)_pFile;
+
+	unmapFile(pFile->file);
+	delete pFile;
+}
+
+static size_t readMappedObjFile(
+	void* _pFile,
+	void* _pDestination,
+	size_t _byteSize,
+	void* _pUserData)
+{
+	MappedObjFile* pFile = (MappedObjFile*)_pFile;
+
+	size_t byteSize = glm::min(_byteSize, pFile->file.byteSize - pFile->readOffset);
+	memcpy(_pDestination, pFile->file.pData + pFile->readOffset, byteSize);
+	pFile->readOffset += byteSize;
+
+	return byteSize;
+}
+
+static unsigned long getMappedObjFileSize(
+	void* _pFile,
+	void* _pUserData)
+{
+	return (unsigned long)((MappedObjFile*)_pFile)->file.byteSize;
+}
+
+struct ObjIndexHash
+{
+	size_t operator()(
+		const fastObjIndex& _rIndex) const
+	{
+		return size_t(_rIndex.p) * 73856093u ^ size_t(_rIndex.n) * 19349663u ^ size_t(_rIndex.t) * 83492791u;
+	}
+};
+
+struct ObjIndexEqual
+{
+	bool operator()(
+		const fastObjIndex& _rLeft,
+		const fastObjIndex& _rRight) const
+	{
+		return _rLeft.p == _rRight.p && _rLeft.n == _rRight.n && _rLeft.t == _rRight.t;
+	}
+};
+
+// Marks an empty slot of the unique vertex table in readObjMesh.
+const u32 kEmptyObjIndexSlot = ~0u;
+
+// OBJ text is parsed in chunks straight out of a file mapping, and unique (p, n, t) index triplets
+// become vertices while streaming through the indices, so no per index vertex is ever expanded.
+bool readObjMesh(
+	const char* _pFilePath,
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices)
+{
+	EASY_BLOCK("ReadObjMesh");
+
+	fastObjCallbacks callbacks = {
+		.file_open = openMappedObjFile,
+		.file_close = closeMappedObjFile,
+		.file_read = readMappedObjFile,
+		.file_size = getMappedObjFileSize };
+
+	fastObjMesh* objMesh = fast_obj_read_with_callbacks(_pFilePath, &callbacks, nullptr);
+	if (!objMesh)
+	{
+		return false;
+	}
+
+	// Unique triplets are found through an open addressing table of the first index which referenced each of them,
+	// whose vertex is already in the index buffer. It's a single scratch allocation, which stays at most half full
+	// even when every index is unique, so linear probing stays short.
+	size_t slotCount = 1u;
+	while (slotCount < 2u * size_t(objMesh->index_count))
+	{
+		slotCount *= 2u;
+	}
+
+	ScratchVector<u32> firstIndices(slotCount, kEmptyObjIndexSlot);
+
+	_rVertices.reserve(objMesh->position_count);
+	_rIndices.resize(objMesh->index_count);
+
+	for (u32 i = 0; i < objMesh->index_count; ++i)
+	{
+		fastObjIndex vertexIndex = objMesh->indices[i];
+		size_t slot = ObjIndexHash()(vertexIndex) & (slotCount - 1u);
+
+		while (firstIndices[slot] != kEmptyObjIndexSlot && !ObjIndexEqual()(objMesh->indices[firstIndices[slot]], vertexIndex))
+		{
+			slot = (slot + 1u) & (slotCount - 1u);
+		}
+
+		if (firstIndices[slot] != kEmptyObjIndexSlot)
+		{
+			_rIndices[i] = _rIndices[firstIndices[slot]];
+			continue;
+		}
+
+		firstIndices[slot] = i;
+		_rIndices[i] = u32(_rVertices.size());
+
+		RawVertex vertex{};
+
+		vertex.position[0] = objMesh->positions[3 * size_t(vertexIndex.p) + 0];
+		vertex.position[1] = objMesh->positions[3 * size_t(vertexIndex.p) + 1];
+		vertex.position[2] = objMesh->positions[3 * size_t(vertexIndex.p) + 2];
+
+		// TODO-MILKRU: We can calculate normals from depth buffer after first geometry phase.
+		// See Wicked engine article about this.
+		vertex.normal[0] = objMesh->normals[3 * size_t(vertexIndex.n) + 0];
+		vertex.normal[1] = objMesh->normals[3 * size_t(vertexIndex.n) + 1];
+		vertex.normal[2] = objMesh->normals[3 * size_t(vertexIndex.n) + 2];
+
+		vertex.texCoord[0] = objMesh->texcoords[2 * size_t(vertexIndex.t) + 0];
+		vertex.texCoord[1] = objMesh->texcoords[2 * size_t(vertexIndex.t) + 1];
+
+		_rVertices.push_back(vertex);
+	}
+
+	// Source data isn't needed anymore, so it's released before the much heavier processing starts.
+	fast_obj_destroy(objMesh);
+
+	return !_rIndices.empty();
+}
+
+// Triangles are split at their median centroid along the longest axis of the centroid bounds, until every chunk is small enough.
+// Chunks keep the original triangle order, so vertex cache optimization still holds within each of them.
+static std::vector<std::vector<u32>> splitMeshChunks(
+	std::vector<u32>& _rIndices,
+	std::vector<RawVertex>& _rVertices,
+	u32 _maxTriangleCount)
+{
+	EASY_BLOCK("SplitMeshChunks");
+
+	u32 triangleCount = u32(_rIndices.size() / 3);
+
+	if (_maxTriangleCount == 0u || triangleCount <= _maxTriangleCount)
+	{
+		return { _rIndices };
+	}
+
+	ScratchVector<v3> centroids(triangleCount);
+
+	for (u32 triangleIndex = 0u; triangleIndex < triangleCount; ++triangleIndex)
+	{
+		v3 centroid(0.0f);
+
+		for (u32 corner = 0u; corner < 3u; ++corner)
+		{
+			const RawVertex& rVertex = _rVertices[_rIndices[3 * size_t(triangleIndex) + corner]];
+			centroid += v3(rVertex.position[0], rVertex.position[1], rVertex.position[2]);
+		}
+
+		centroids[triangleIndex] = centroid / 3.0f;
+	}
+
+	ScratchVector<u32> triangles(triangleCount);
+	std::iota(triangles.begin(), triangles.end(), 0u);
+
+	// Ranges are (first triangle, triangle count) pairs, split depth first so chunks stay spatially ordered.
+	ScratchVector<uv2> pendingRanges = { uv2(0u, triangleCount) };
+	std::vector<std::vector<u32>> chunks;
+
+	while (!pendingRanges.empty())
+	{
+		uv2 range = pendingRanges.back();
+		pendingRanges.pop_back();
+
+		u32* pFirstTriangle = &triangles[range.x];
+
+		if (range.y <= _maxTriangleCount)
+		{
+			std::sort(pFirstTriangle, pFirstTriangle + range.y);
+
+			std::vector<u32>& rChunk = chunks.emplace_back();
+			rChunk.reserve(3 * size_t(range.y));
+
+			for (u32 triangleIndex = 0u; triangleIndex < range.y; ++triangleIndex)
+			{
+				u32* pTriangle = &_rIndices[3 * size_t(pFirstTriangle[triangleIndex])];
+				rChunk.insert(rChunk.end(), pTriangle, pTriangle + 3);
+			}
+
+			continue;
+		}
+
+		v3 centroidMin(FLT_MAX);
+		v3 centroidMax(-FLT_MAX);
+
+		for (u32 triangleIndex = 0u; triangleIndex < range.y; ++triangleIndex)
+		{
+			centroidMin = glm::min(centroidMin, centroids[pFirstTriangle[triangleIndex]]);
+			centroidMax = glm::max(centroidMax, centroids[pFirstTriangle[triangleIndex]]);
+		}
+
+		v3 centroidExtent = centroidMax - centroidMin;
+		u32 axis = centroidExtent.x >= centroidExtent.y && centroidExtent.x >= centroidExtent.z ? 0u :
+			centroidExtent.y >= centroidExtent.z ? 1u : 2u;
+
+		u32 halfTriangleCount = range.y / 2;
+
+		std::nth_element(pFirstTriangle, pFirstTriangle + halfTriangleCount, pFirstTriangle + range.y,
+			[&](u32 _left, u32 _right)
+			{
+				return centroids[_left][axis] < centroids[_right][axis];
+			});
+
+		pendingRanges.push_back(uv2(range.x + halfTriangleCount, range.y - halfTriangleCount));
+		pendingRanges.push_back(uv2(range.x, halfTriangleCount));
+	}
+
+	return chunks;
+}
+
+// Bounds only cover vertices referenced by the mesh, since chunks share the whole vertex range.
+static void calculateMeshBounds(
+	Mesh& _rMesh,
+	std::vector<u32>& _rIndices,
+	std::vector<RawVertex>& _rVertices)
+{
+	ScratchVector<u32> meshVertices;
+	ScratchVector<u8> vertexVisited(_rVertices.size(), 0u);
+
+	v3 boxMin(FLT_MAX);
+	v3 boxMax(-FLT_MAX);
+
+	for (u32 vertexIndex : _rIndices)
+	{
+		if (vertexVisited[vertexIndex])
+		{
+			continue;
+		}
+
+		vertexVisited[vertexIndex] = 1u;
+		meshVertices.push_back(vertexIndex);
+
+		const RawVertex& rVertex = _rVertices[vertexIndex];
+		v3 position(rVertex.position[0], rVertex.position[1], rVertex.position[2]);
+
+		boxMin = glm::min(boxMin, position);
+		boxMax = glm::max(boxMax, position);
+	}
+
+	BoundingSphere sphere = calculateBoundingSphere(&_rVertices[0].position[0], sizeof(RawVertex),
+		meshVertices.data(), meshVertices.size());
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		_rMesh.center[axis] = sphere.center[axis];
+		_rMesh.boxCenter[axis] = 0.5f * (boxMin[axis] + boxMax[axis]);
+		_rMesh.boxExtent[axis] = 0.5f * (boxMax[axis] - boxMin[axis]);
+	}
+
+	_rMesh.radius = sphere.radius;
+}
+
+// Geometry streams still grow geometrically across meshes, but never more than once per mesh.
+template<typename T>
+static void reserveAppend(
+	std::vector<T>& _rStream,
+	size_t _count)
+{
+	size_t requiredCount = _rStream.size() + _count;
+
+	if (requiredCount > _rStream.capacity())
+	{
+		_rStream.reserve(glm::max(requiredCount, 2 * _rStream.capacity()));
+	}
+}
+
+struct MeshImportStats
+{
+	u32 compactedVertexCount = 0u;
+	u32 shortIndexCount = 0u;
+	u32 indexCount = 0u;
+};
+
+// Builds LODs, meshlets and the cluster hierarchy of a single Mesh, whose vertices were already quantized into the geometry.
+static void buildMesh(
+	Geometry& _rGeometry,
+	const Mesh& _rBaseMesh,
+	std::vector<u32>& _rIndices,
+	std::vector<RawVertex>& _rVertices,
+	const char* _pFilePath,
+	MeshProcessingDesc _processingDesc,
+	u32 _simplifyOptions,
+	MeshImportStats& _rStats)
+{
+	Mesh mesh = _rBaseMesh;
+
+	calculateMeshBounds(mesh, _rIndices, _rVertices);
+
+	// Position only LODs are simplified over indices which weld vertices sharing a position, so they collapse across
+	// normal and texture coordinate seams as well. Welded indices point at the first of those vertices, so LODs
+	// still fetch from the same vertices.
+	std::vector<u32> positionIndices;
+	if (_processingDesc.bPositionOnlyLods)
+	{
+		positionIndices.resize(_rIndices.size());
+		meshopt_generateShadowIndexBuffer(positionIndices.data(), _rIndices.data(), _rIndices.size(),
+			&_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex::position), sizeof(RawVertex));
+	}
+
+	// Sloppy simplification ignores locked borders, so it would open cracks between chunks.
+	bool bSloppyLods = _processingDesc.bSloppyLods && (_simplifyOptions & meshopt_SimplifyLockBorder) == 0u;
+	const std::vector<u32>& rSimplifyIndices = positionIndices.empty() ? _rIndices : positionIndices;
+
+	std::vector<f32> lodErrors;
+	std::vector<std::vector<u32>> lodIndices = _processingDesc.bParallelLods ?
+		buildIndependentLods(_rIndices, rSimplifyIndices, _rVertices, _processingDesc, _simplifyOptions, bSloppyLods, lodErrors) :
+		buildLodChain(_rIndices, rSimplifyIndices, _rVertices, _processingDesc, _simplifyOptions, bSloppyLods, lodErrors);
+
+	// Relative errors are converted into mesh space, so they can be projected onto the screen for the LOD selection.
+	f32 errorScale = meshopt_simplifyScale(&_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex));
+
+	// Coarse LODs only touch a small scattered subset of vertices, so they can get their own compacted vertex range,
+	// in the order of first use. LOD0 keeps the mesh vertex range, which is shared with the cluster hierarchy and other chunks.
+	std::vector<std::vector<u32>> lodVertexRemaps(lodIndices.size());
+	std::vector<std::vector<RawVertex>> lodCompactedVertices(lodIndices.size());
+
+	if (_processingDesc.bCompactLodVertices)
+	{
+		jobs::parallelFor(u32(lodIndices.size()) - 1u, [&](u32 _jobIndex)
+			{
+				u32 lodIndex = _jobIndex + 1u;
+				std::vector<u32>& rIndices = lodIndices[lodIndex];
+				std::vector<u32>& rRemap = lodVertexRemaps[lodIndex];
+
+				rRemap.resize(_rVertices.size());
+				size_t vertexCount = meshopt_optimizeVertexFetchRemap(rRemap.data(), rIndices.data(), rIndices.size(), _rVertices.size());
+				meshopt_remapIndexBuffer(rIndices.data(), rIndices.data(), rIndices.size(), rRemap.data());
+
+				lodCompactedVertices[lodIndex].resize(vertexCount);
+				meshopt_remapVertexBuffer(lodCompactedVertices[lodIndex].data(), _rVertices.data(), _rVertices.size(), sizeof(RawVertex), rRemap.data());
+			});
+	}
+
+	// Meshlets are always built, so baked geometry doesn't depend on the device it was created on.
+	std::vector<LodMeshlets> lodMeshlets(lodIndices.size());
+
+	jobs::parallelFor(u32(lodIndices.size()), [&](u32 _lodIndex)
+		{
+			std::vector<RawVertex>& rLodVertices = lodCompactedVertices[_lodIndex].empty() ? _rVertices : lodCompactedVertices[_lodIndex];
+			buildLodMeshlets(lodMeshlets[_lodIndex], lodIndices[_lodIndex], rLodVertices, _processingDesc);
+		});
+
+	// Level 0 clusters are LOD0 meshlets, so the hierarchy is built before meshlets get rebased below.
+	ClusterHierarchy clusterHierarchy;
+
+	if (_processingDesc.bClusterHierarchy)
+	{
+		LodMeshlets& rBaseMeshlets = lodMeshlets[0];
+
+		buildClusterHierarchy(clusterHierarchy, rBaseMeshlets.meshlets.data(), u32(rBaseMeshlets.meshlets.size()),
+			rBaseMeshlets.meshletVertices.data(), rBaseMeshlets.meshletTriangles.data(),
+			_rVertices.data(), _rVertices.size(), _processingDesc.meshletConeWeight);
+	}
+
+	mesh.lodCount = u32(lodIndices.size());
+
+	// Counting pass reserves room for the whole mesh in the geometry streams, instead of growing them LOD by LOD.
+	size_t vertexCount = 0u;
+	size_t indexCount = 0u;
+	size_t meshletCount = clusterHierarchy.meshlets.size();
+	size_t meshletVertexCount = clusterHierarchy.meshletVertices.size();
+	size_t meshletTriangleCount = clusterHierarchy.meshletTriangles.size();
+
+	for (u32 lodIndex = 0u; lodIndex < mesh.lodCount; ++lodIndex)
+	{
+		vertexCount += lodCompactedVertices[lodIndex].size();
+		indexCount += lodIndices[lodIndex].size();
+		meshletCount += lodMeshlets[lodIndex].meshlets.size();
+		meshletVertexCount += lodMeshlets[lodIndex].meshletVertices.size();
+		meshletTriangleCount += lodMeshlets[lodIndex].meshletTriangles.size();
+	}
+
+	reserveAppend(_rGeometry.vertices, vertexCount);
+	reserveAppend(_rGeometry.indices, indexCount);
+	reserveAppend(_rGeometry.meshlets, meshletCount);
+	reserveAppend(_rGeometry.meshletVertices, meshletVertexCount);
+	reserveAppend(_rGeometry.meshletTriangles, meshletTriangleCount);
+	reserveAppend(_rGeometry.clusters, clusterHierarchy.clusters.size());
+
+	for (u32 lodIndex = 0u; lodIndex < mesh.lodCount; ++lodIndex)
+	{
+		std::vector<u32>& rIndices = lodIndices[lodIndex];
+		LodMeshlets& rLodMeshlets = lodMeshlets[lodIndex];
+		std::vector<u32>& rVertexRemap = lodVertexRemaps[lodIndex];
+
+		mesh.lods[lodIndex].vertexOffset = mesh.vertexOffset;
+
+		// Compacted vertices are copied out of the already quantized mesh vertices.
+		if (!rVertexRemap.empty())
+		{
+			u32 compactedVertexCount = u32(lodCompactedVertices[lodIndex].size());
+
+			mesh.lods[lodIndex].vertexOffset = u32(_rGeometry.vertices.size());
+			_rGeometry.vertices.resize(_rGeometry.vertices.size() + compactedVertexCount);
+
+			meshopt_remapVertexBuffer(&_rGeometry.vertices[mesh.lods[lodIndex].vertexOffset], &_rGeometry.vertices[mesh.vertexOffset],
+				_rVertices.size(), sizeof(Vertex), rVertexRemap.data());
+
+			_rStats.compactedVertexCount += compactedVertexCount;
+		}
+
+		mesh.lods[lodIndex].error = lodErrors[lodIndex] * errorScale;
+
+		mesh.lods[lodIndex].firstIndex = u32(_rGeometry.indices.size());
+		mesh.lods[lodIndex].indexCount = u32(rIndices.size());
+		_rGeometry.indices.insert(_rGeometry.indices.end(), rIndices.begin(), rIndices.end());
+
+		// Indices are relative to the LOD vertex offset, so LODs which touch less than 64K vertices can use 16 bit indices.
+		mesh.lods[lodIndex].bShortIndices = *std::max_element(rIndices.begin(), rIndices.end()) <= UINT16_MAX ? 1u : 0u;
+		_rStats.shortIndexCount += mesh.lods[lodIndex].bShortIndices ? u32(rIndices.size()) : 0u;
+		_rStats.indexCount += u32(rIndices.size());
+
+		mesh.lods[lodIndex].meshletOffset = u32(_rGeometry.meshlets.size());
+		mesh.lods[lodIndex].meshletCount = u32(rLodMeshlets.meshlets.size());
+
+		u32 globalMeshletVerticesOffset = u32(_rGeometry.meshletVertices.size());
+		u32 globalMeshletTrianglesOffset = u32(_rGeometry.meshletTriangles.size());
+
+		for (Meshlet& rMeshlet : rLodMeshlets.meshlets)
+		{
+			rMeshlet.vertexOffset += globalMeshletVerticesOffset;
+			rMeshlet.triangleOffset += globalMeshletTrianglesOffset;
+		}
+
+		_rGeometry.meshlets.insert(_rGeometry.meshlets.end(), rLodMeshlets.meshlets.begin(), rLodMeshlets.meshlets.end());
+		_rGeometry.meshletVertices.insert(_rGeometry.meshletVertices.end(), rLodMeshlets.meshletVertices.begin(), rLodMeshlets.meshletVertices.end());
+		_rGeometry.meshletTriangles.insert(_rGeometry.meshletTriangles.end(), rLodMeshlets.meshletTriangles.begin(), rLodMeshlets.meshletTriangles.end());
+
+		calculateMeshletBoxes(_rGeometry, mesh.lods[lodIndex].meshletOffset, mesh.lods[lodIndex].meshletCount, mesh.lods[lodIndex].vertexOffset);
+	}
+
+	if (!clusterHierarchy.clusters.empty())
+	{
+		u32 baseMeshletCount = mesh.lods[0].meshletCount;
+		u32 hierarchyMeshletOffset = u32(_rGeometry.meshlets.size());
+		u32 globalMeshletVerticesOffset = u32(_rGeometry.meshletVertices.size());
+		u32 globalMeshletTrianglesOffset = u32(_rGeometry.meshletTriangles.size());
+
+		for (Meshlet& rMeshlet : clusterHierarchy.meshlets)
+		{
+			rMeshlet.vertexOffset += globalMeshletVerticesOffset;
+			rMeshlet.triangleOffset += globalMeshletTrianglesOffset;
+		}
+
+		for (Cluster& rCluster : clusterHierarchy.clusters)
+		{
+			rCluster.meshletIndex = rCluster.meshletIndex < baseMeshletCount ?
+				mesh.lods[0].meshletOffset + rCluster.meshletIndex :
+				hierarchyMeshletOffset + rCluster.meshletIndex - baseMeshletCount;
+		}
+
+		mesh.clusterOffset = u32(_rGeometry.clusters.size());
+		mesh.clusterCount = u32(clusterHierarchy.clusters.size());
+
+		_rGeometry.meshlets.insert(_rGeometry.meshlets.end(), clusterHierarchy.meshlets.begin(), clusterHierarchy.meshlets.end());
+		_rGeometry.meshletVertices.insert(_rGeometry.meshletVertices.end(), clusterHierarchy.meshletVertices.begin(), clusterHierarchy.meshletVertices.end());
+		_rGeometry.meshletTriangles.insert(_rGeometry.meshletTriangles.end(), clusterHierarchy.meshletTriangles.begin(), clusterHierarchy.meshletTriangles.end());
+		_rGeometry.clusters.insert(_rGeometry.clusters.end(), clusterHierarchy.clusters.begin(), clusterHierarchy.clusters.end());
+
+		calculateMeshletBoxes(_rGeometry, hierarchyMeshletOffset, u32(clusterHierarchy.meshlets.size()), mesh.vertexOffset);
+
+		if (_processingDesc.bVerbose)
+		{
+			printf("Built cluster hierarchy for %s, %u clusters in %u levels.\n",
+				_pFilePath, mesh.clusterCount, clusterHierarchy.levelCount);
+		}
+	}
+
+	if (_processingDesc.bStreamingPages)
+	{
+		buildGeometryPages(_rGeometry, mesh);
+	}
+
+	_rGeometry.meshes.push_back(mesh);
+}
+
+void optimizeMeshData(
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices)
+{
+	meshopt_optimizeVertexCache(_rIndices.data(), _rIndices.data(), _rIndices.size(), _rVertices.size());
+	meshopt_optimizeOverdraw(_rIndices.data(), _rIndices.data(), _rIndices.size(), &_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex), /*threshold*/ 1.01f);
+	meshopt_optimizeVertexFetch(_rVertices.data(), _rIndices.data(), _rIndices.size(), _rVertices.data(), _rVertices.size(), sizeof(RawVertex));
+}
+
+void importMeshData(
+	Geometry& _rGeometry,
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices,
+	const char* _pName,
+	MeshProcessingDesc _processingDesc)
+{
+	optimizeMeshData(_rVertices, _rIndices);
+
+	Mesh mesh = {};
+
+	QuantizationFrame quantizationFrame = calculateQuantizationFrame(_rVertices.data(), _rVertices.size());
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		mesh.positionOffset[axis] = quantizationFrame.positionOffset[axis];
+		mesh.positionScale[axis] = quantizationFrame.positionScale[axis];
+	}
+
+	for (u32 axis = 0; axis < 2; ++axis)
+	{
+		mesh.texCoordOffset[axis] = quantizationFrame.texCoordOffset[axis];
+		mesh.texCoordScale[axis] = quantizationFrame.texCoordScale[axis];
+	}
+
+	mesh.vertexOffset = u32(_rGeometry.vertices.size());
+	_rGeometry.vertices.resize(_rGeometry.vertices.size() + _rVertices.size());
+
+	quantizeVertices(_rVertices.data(), _rVertices.size(), quantizationFrame, &_rGeometry.vertices[mesh.vertexOffset]);
+
+	if (_processingDesc.bVerbose)
+	{
+		BoundingSphere sphere = calculateBoundingSphere(&_rVertices[0].position[0], sizeof(RawVertex), nullptr, _rVertices.size());
+		QuantizationError quantizationError = calculateQuantizationError(_rVertices.data(),
+			&_rGeometry.vertices[mesh.vertexOffset], _rVertices.size(), quantizationFrame);
+
+		printf("Quantized %s, max error: position %.6f (%.4f%% of radius), normal %.3f deg, texture coordinate %.6f.\n",
+			_pName, quantizationError.position, 100.0f * quantizationError.position / glm::max(sphere.radius, FLT_MIN),
+			quantizationError.normal, quantizationError.texCoord);
+	}
+
+	// Chunks share vertices along their borders, which stay locked while simplifying, so LODs of neighbouring chunks always match.
+	std::vector<std::vector<u32>> chunks = splitMeshChunks(_rIndices, _rVertices, _processingDesc.chunkTriangleCount);
+	u32 simplifyOptions = chunks.size() > 1 ? meshopt_SimplifyLockBorder : 0u;
+
+	if (_processingDesc.bVerbose && chunks.size() > 1)
+	{
+		printf("Split %s into %zu chunks.\n", _pName, chunks.size());
+	}
+
+	MeshImportStats stats;
+
+	for (std::vector<u32>& rChunkIndices : chunks)
+	{
+		buildMesh(_rGeometry, mesh, rChunkIndices, _rVertices, _pName, _processingDesc, simplifyOptions, stats);
+	}
+
+	if (_processingDesc.bVerbose && stats.compactedVertexCount > 0u)
+	{
+		printf("Compacted LOD vertices of %s, %u vertices added to %zu.\n", _pName, stats.compactedVertexCount, _rVertices.size());
+	}
+
+	if (_processingDesc.bVerbose)
+	{
+		printf("Indices of %s, %u of %u fit into 16 bits.\n", _pName, stats.shortIndexCount, stats.indexCount);
+	}
+}
+
+void importMesh(
+	Geometry& _rGeometry,
+	const char* _pFilePath,
+	MeshProcessingDesc _processingDesc)
+{
+	if (isGltfPath(_pFilePath))
+	{
+		importGltfScene(_rGeometry, _pFilePath, _processingDesc);
+		return;
+	}
+
+	std::vector<RawVertex> vertices;
+	std::vector<u32> indices;
+
+	bool bRead = readObjMesh(_pFilePath, vertices, indices);
+	assert(bRead);
+
+	importMeshData(_rGeometry, vertices, indices, _pFilePath, _processingDesc);
+}
+
+// Every processing parameter which affects the imported result has to be part of this hash, bVerbose doesn't.
+u32 calculateProcessingHash(
+	MeshProcessingDesc _processingDesc)
+{
+	u32 hash = CRC::Calculate(&_processingDesc.lodIndexRatio, sizeof(_processingDesc.lodIndexRatio), CRC::CRC_32());
+	hash = CRC::Calculate(&_processingDesc.lodTargetError, sizeof(_processingDesc.lodTargetError), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.meshletConeWeight, sizeof(_processingDesc.meshletConeWeight), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.bParallelLods, sizeof(_processingDesc.bParallelLods), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.bClusterHierarchy, sizeof(_processingDesc.bClusterHierarchy), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.bStreamingPages, sizeof(_processingDesc.bStreamingPages), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.chunkTriangleCount, sizeof(_processingDesc.chunkTriangleCount), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.bCompactLodVertices, sizeof(_processingDesc.bCompactLodVertices), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.bSloppyLods, sizeof(_processingDesc.bSloppyLods), CRC::CRC_32(), hash);
+	hash = CRC::Calculate(&_processingDesc.bPositionOnlyLods, sizeof(_processingDesc.bPositionOnlyLods), CRC::CRC_32(), hash);
+	return hash;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// Mesh import doesn't touch the device, so it's shared with the offline bake tool.
+
+struct RawVertex
+{
+	f32 position[3];
+	f32 normal[3];
+	f32 texCoord[2];
+};
+
+// Unique OBJ index triplets become vertices, so tools can work on the same vertices and indices as import.
+bool readObjMesh(
+	const char* _pFilePath,
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices);
+
+// Vertex cache, overdraw and vertex fetch optimization, which import runs first.
+void optimizeMeshData(
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices);
+
+// Optimizes, quantizes and splits already read vertices and indices, then builds LODs and meshlets of the resulting meshes.
+void importMeshData(
+	Geometry& _rGeometry,
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices,
+	const char* _pName,
+	MeshProcessingDesc _processingDesc);
+
+// OBJ files become a single mesh, while glTF scenes are imported through importGltfScene.
+void importMesh(
+	Geometry& _rGeometry,
+	const char* _pFilePath,
+	MeshProcessingDesc _processingDesc);
+
+u32 calculateProcessingHash(
+	MeshProcessingDesc _processingDesc);
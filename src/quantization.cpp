@@ -0,0 +1,649 @@
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "mesh_import.h"
+#include "quantization.h"
+
+#include <meshoptimizer.h>
+#include <float.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define QUANTIZATION_SIMD 1
+#include <immintrin.h>
+#else
+#define QUANTIZATION_SIMD 0
+#endif // x86
+
+// MSVC allows any intrinsic anywhere, while GCC and Clang need them enabled per function.
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SIMD_TARGET(_target)
+#else
+#define SIMD_TARGET(_target) __attribute__((target(_target)))
+#endif // _MSC_VER
+
+// RawVertex is loaded as 8 floats: position xyz, normal xyz and texture coordinate uv.
+static_assert(sizeof(RawVertex) == 8 * sizeof(f32));
+
+const u32 kRawVertexTexCoordLane = 6u;
+
+static f32 getInverseScale(
+	f32 _scale)
+{
+	return _scale > 0.0f ? 1.0f / _scale : 0.0f;
+}
+
+// Octahedral normal encoding, see "A Survey of Efficient Representations for Independent Unit Vectors".
+// https://jcgt.org/published/0003/02/01/
+static v2 encodeOctahedral(
+	v3 _normal)
+{
+	f32 normalLength = glm::abs(_normal.x) + glm::abs(_normal.y) + glm::abs(_normal.z);
+	if (normalLength == 0.0f)
+	{
+		return v2(0.0f);
+	}
+
+	_normal /= normalLength;
+
+	v2 encoded = v2(_normal);
+	if (_normal.z < 0.0f)
+	{
+		encoded = (1.0f - glm::abs(v2(encoded.y, encoded.x))) *
+			v2(encoded.x >= 0.0f ? 1.0f : -1.0f, encoded.y >= 0.0f ? 1.0f : -1.0f);
+	}
+
+	return encoded;
+}
+
+static v3 decodeOctahedral(
+	v2 _encoded)
+{
+	v3 normal = v3(_encoded, 1.0f - glm::abs(_encoded.x) - glm::abs(_encoded.y));
+
+	f32 t = glm::max(-normal.z, 0.0f);
+	normal.x += normal.x >= 0.0f ? -t : t;
+	normal.y += normal.y >= 0.0f ? -t : t;
+
+	return glm::normalize(normal);
+}
+
+static f32 decodeSnorm(
+	i32 _value,
+	i32 _bits)
+{
+	return glm::max(f32(_value) / f32((1 << (_bits - 1)) - 1), -1.0f);
+}
+
+static f32 decodeUnorm(
+	u32 _value,
+	i32 _bits)
+{
+	return f32(_value) / f32((1 << _bits) - 1);
+}
+
+static void calculateVertexRangeScalar(
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	f32* _pMin,
+	f32* _pMax)
+{
+	for (size_t vertexIndex = 0; vertexIndex < _vertexCount; ++vertexIndex)
+	{
+		const f32* pVertex = &_pVertices[vertexIndex].position[0];
+
+		for (u32 lane = 0; lane < 8; ++lane)
+		{
+			_pMin[lane] = glm::min(_pMin[lane], pVertex[lane]);
+			_pMax[lane] = glm::max(_pMax[lane], pVertex[lane]);
+		}
+	}
+}
+
+static void quantizeVerticesScalar(
+	const RawVertex* _pRawVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame,
+	Vertex* _pVertices)
+{
+	for (size_t vertexIndex = 0; vertexIndex < _vertexCount; ++vertexIndex)
+	{
+		_pVertices[vertexIndex] = quantizeVertex(_pRawVertices[vertexIndex], _frame);
+	}
+}
+
+#if QUANTIZATION_SIMD
+// Lanes of the quantized SoA registers, written out as Vertex structs.
+struct QuantizedLanes
+{
+	alignas(32) i32 position[3][8];
+	alignas(32) i32 normal[2][8];
+	alignas(32) i32 texCoord[2][8];
+};
+
+static void storeQuantizedLanes(
+	const QuantizedLanes& _rLanes,
+	u32 _laneCount,
+	Vertex* _pVertices)
+{
+	for (u32 lane = 0; lane < _laneCount; ++lane)
+	{
+		Vertex& rVertex = _pVertices[lane];
+
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			rVertex.position[axis] = i16(_rLanes.position[axis][lane]);
+		}
+
+		for (u32 axis = 0; axis < 2; ++axis)
+		{
+			rVertex.normal[axis] = i8(_rLanes.normal[axis][lane]);
+			rVertex.texCoord[axis] = u16(_rLanes.texCoord[axis][lane]);
+		}
+	}
+}
+
+SIMD_TARGET("sse2")
+static void calculateVertexRangeSse(
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	f32* _pMin,
+	f32* _pMax)
+{
+	__m128 minLow = _mm_loadu_ps(_pMin);
+	__m128 minHigh = _mm_loadu_ps(_pMin + 4);
+	__m128 maxLow = _mm_loadu_ps(_pMax);
+	__m128 maxHigh = _mm_loadu_ps(_pMax + 4);
+
+	for (size_t vertexIndex = 0; vertexIndex < _vertexCount; ++vertexIndex)
+	{
+		const f32* pVertex = &_pVertices[vertexIndex].position[0];
+
+		__m128 low = _mm_loadu_ps(pVertex);
+		__m128 high = _mm_loadu_ps(pVertex + 4);
+
+		minLow = _mm_min_ps(minLow, low);
+		minHigh = _mm_min_ps(minHigh, high);
+		maxLow = _mm_max_ps(maxLow, low);
+		maxHigh = _mm_max_ps(maxHigh, high);
+	}
+
+	_mm_storeu_ps(_pMin, minLow);
+	_mm_storeu_ps(_pMin + 4, minHigh);
+	_mm_storeu_ps(_pMax, maxLow);
+	_mm_storeu_ps(_pMax + 4, maxHigh);
+}
+
+SIMD_TARGET("avx2")
+static void calculateVertexRangeAvx2(
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	f32* _pMin,
+	f32* _pMax)
+{
+	__m256 rangeMin = _mm256_loadu_ps(_pMin);
+	__m256 rangeMax = _mm256_loadu_ps(_pMax);
+
+	for (size_t vertexIndex = 0; vertexIndex < _vertexCount; ++vertexIndex)
+	{
+		__m256 vertex = _mm256_loadu_ps(&_pVertices[vertexIndex].position[0]);
+
+		rangeMin = _mm256_min_ps(rangeMin, vertex);
+		rangeMax = _mm256_max_ps(rangeMax, vertex);
+	}
+
+	_mm256_storeu_ps(_pMin, rangeMin);
+	_mm256_storeu_ps(_pMax, rangeMax);
+}
+
+// Same operations in the same order as meshopt_quantizeSnorm and meshopt_quantizeUnorm, so results match the scalar path.
+SIMD_TARGET("sse2")
+static __m128i quantizeSnormSse(
+	__m128 _value,
+	f32 _scale)
+{
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 bPositive = _mm_cmpge_ps(_value, _mm_setzero_ps());
+	__m128 round = _mm_or_ps(_mm_and_ps(bPositive, half), _mm_andnot_ps(bPositive, _mm_set1_ps(-0.5f)));
+
+	__m128 value = _mm_min_ps(_mm_max_ps(_value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(_scale)), round));
+}
+
+SIMD_TARGET("sse2")
+static __m128i quantizeUnormSse(
+	__m128 _value,
+	f32 _scale)
+{
+	__m128 value = _mm_min_ps(_mm_max_ps(_value, _mm_setzero_ps()), _mm_set1_ps(1.0f));
+	return _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(value, _mm_set1_ps(_scale)), _mm_set1_ps(0.5f)));
+}
+
+SIMD_TARGET("sse2")
+static __m128 getSignSse(
+	__m128 _value)
+{
+	__m128 bPositive = _mm_cmpge_ps(_value, _mm_setzero_ps());
+	return _mm_or_ps(_mm_and_ps(bPositive, _mm_set1_ps(1.0f)), _mm_andnot_ps(bPositive, _mm_set1_ps(-1.0f)));
+}
+
+SIMD_TARGET("sse2")
+static void quantizeVerticesSse(
+	const RawVertex* _pRawVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame,
+	Vertex* _pVertices)
+{
+	const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+	__m128 positionOffset[3];
+	__m128 positionInverseScale[3];
+	__m128 texCoordOffset[2];
+	__m128 texCoordInverseScale[2];
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		positionOffset[axis] = _mm_set1_ps(_frame.positionOffset[axis]);
+		positionInverseScale[axis] = _mm_set1_ps(getInverseScale(_frame.positionScale[axis]));
+	}
+
+	for (u32 axis = 0; axis < 2; ++axis)
+	{
+		texCoordOffset[axis] = _mm_set1_ps(_frame.texCoordOffset[axis]);
+		texCoordInverseScale[axis] = _mm_set1_ps(getInverseScale(_frame.texCoordScale[axis]));
+	}
+
+	QuantizedLanes lanes;
+
+	size_t batchVertexCount = _vertexCount & ~size_t(3);
+
+	for (size_t vertexIndex = 0; vertexIndex < batchVertexCount; vertexIndex += 4)
+	{
+		const f32* pVertices = &_pRawVertices[vertexIndex].position[0];
+
+		// Position xyz and normal x, then normal yz and texture coordinate uv, transposed into SoA registers.
+		__m128 px = _mm_loadu_ps(pVertices + 0);
+		__m128 py = _mm_loadu_ps(pVertices + 8);
+		__m128 pz = _mm_loadu_ps(pVertices + 16);
+		__m128 nx = _mm_loadu_ps(pVertices + 24);
+		_MM_TRANSPOSE4_PS(px, py, pz, nx);
+
+		__m128 ny = _mm_loadu_ps(pVertices + 4);
+		__m128 nz = _mm_loadu_ps(pVertices + 12);
+		__m128 u = _mm_loadu_ps(pVertices + 20);
+		__m128 v = _mm_loadu_ps(pVertices + 28);
+		_MM_TRANSPOSE4_PS(ny, nz, u, v);
+
+		__m128 position[3] = { px, py, pz };
+
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			__m128 delta = _mm_sub_ps(position[axis], positionOffset[axis]);
+			_mm_store_si128((__m128i*)lanes.position[axis], quantizeSnormSse(_mm_mul_ps(delta, positionInverseScale[axis]), 32767.0f));
+		}
+
+		__m128 normalLength = _mm_add_ps(_mm_add_ps(_mm_and_ps(nx, absMask), _mm_and_ps(ny, absMask)), _mm_and_ps(nz, absMask));
+		__m128 bZeroNormal = _mm_cmpeq_ps(normalLength, _mm_setzero_ps());
+
+		nx = _mm_div_ps(nx, normalLength);
+		ny = _mm_div_ps(ny, normalLength);
+		nz = _mm_div_ps(nz, normalLength);
+
+		__m128 bLowerHemisphere = _mm_cmplt_ps(nz, _mm_setzero_ps());
+		__m128 foldedX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_and_ps(ny, absMask)), getSignSse(nx));
+		__m128 foldedY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_and_ps(nx, absMask)), getSignSse(ny));
+
+		__m128 encodedX = _mm_or_ps(_mm_and_ps(bLowerHemisphere, foldedX), _mm_andnot_ps(bLowerHemisphere, nx));
+		__m128 encodedY = _mm_or_ps(_mm_and_ps(bLowerHemisphere, foldedY), _mm_andnot_ps(bLowerHemisphere, ny));
+
+		_mm_store_si128((__m128i*)lanes.normal[0], quantizeSnormSse(_mm_andnot_ps(bZeroNormal, encodedX), 127.0f));
+		_mm_store_si128((__m128i*)lanes.normal[1], quantizeSnormSse(_mm_andnot_ps(bZeroNormal, encodedY), 127.0f));
+
+		_mm_store_si128((__m128i*)lanes.texCoord[0], quantizeUnormSse(
+			_mm_mul_ps(_mm_sub_ps(u, texCoordOffset[0]), texCoordInverseScale[0]), 65535.0f));
+		_mm_store_si128((__m128i*)lanes.texCoord[1], quantizeUnormSse(
+			_mm_mul_ps(_mm_sub_ps(v, texCoordOffset[1]), texCoordInverseScale[1]), 65535.0f));
+
+		storeQuantizedLanes(lanes, 4u, &_pVertices[vertexIndex]);
+	}
+
+	quantizeVerticesScalar(&_pRawVertices[batchVertexCount],
+		_vertexCount - batchVertexCount, _frame, &_pVertices[batchVertexCount]);
+}
+
+SIMD_TARGET("avx2")
+static __m256i quantizeSnormAvx2(
+	__m256 _value,
+	f32 _scale)
+{
+	__m256 bPositive = _mm256_cmp_ps(_value, _mm256_setzero_ps(), _CMP_GE_OQ);
+	__m256 round = _mm256_blendv_ps(_mm256_set1_ps(-0.5f), _mm256_set1_ps(0.5f), bPositive);
+
+	__m256 value = _mm256_min_ps(_mm256_max_ps(_value, _mm256_set1_ps(-1.0f)), _mm256_set1_ps(1.0f));
+	return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(_scale)), round));
+}
+
+SIMD_TARGET("avx2")
+static __m256i quantizeUnormAvx2(
+	__m256 _value,
+	f32 _scale)
+{
+	__m256 value = _mm256_min_ps(_mm256_max_ps(_value, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+	return _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(value, _mm256_set1_ps(_scale)), _mm256_set1_ps(0.5f)));
+}
+
+SIMD_TARGET("avx2")
+static __m256 getSignAvx2(
+	__m256 _value)
+{
+	__m256 bPositive = _mm256_cmp_ps(_value, _mm256_setzero_ps(), _CMP_GE_OQ);
+	return _mm256_blendv_ps(_mm256_set1_ps(-1.0f), _mm256_set1_ps(1.0f), bPositive);
+}
+
+// Eight AoS vertices become eight SoA registers, one per RawVertex component.
+SIMD_TARGET("avx2")
+static void transposeVerticesAvx2(
+	__m256* _pRows)
+{
+	__m256 t0 = _mm256_unpacklo_ps(_pRows[0], _pRows[1]);
+	__m256 t1 = _mm256_unpackhi_ps(_pRows[0], _pRows[1]);
+	__m256 t2 = _mm256_unpacklo_ps(_pRows[2], _pRows[3]);
+	__m256 t3 = _mm256_unpackhi_ps(_pRows[2], _pRows[3]);
+	__m256 t4 = _mm256_unpacklo_ps(_pRows[4], _pRows[5]);
+	__m256 t5 = _mm256_unpackhi_ps(_pRows[4], _pRows[5]);
+	__m256 t6 = _mm256_unpacklo_ps(_pRows[6], _pRows[7]);
+	__m256 t7 = _mm256_unpackhi_ps(_pRows[6], _pRows[7]);
+
+	__m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	__m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	__m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+	_pRows[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	_pRows[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	_pRows[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	_pRows[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	_pRows[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	_pRows[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	_pRows[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	_pRows[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+SIMD_TARGET("avx2")
+static void quantizeVerticesAvx2(
+	const RawVertex* _pRawVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame,
+	Vertex* _pVertices)
+{
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+
+	__m256 positionOffset[3];
+	__m256 positionInverseScale[3];
+	__m256 texCoordOffset[2];
+	__m256 texCoordInverseScale[2];
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		positionOffset[axis] = _mm256_set1_ps(_frame.positionOffset[axis]);
+		positionInverseScale[axis] = _mm256_set1_ps(getInverseScale(_frame.positionScale[axis]));
+	}
+
+	for (u32 axis = 0; axis < 2; ++axis)
+	{
+		texCoordOffset[axis] = _mm256_set1_ps(_frame.texCoordOffset[axis]);
+		texCoordInverseScale[axis] = _mm256_set1_ps(getInverseScale(_frame.texCoordScale[axis]));
+	}
+
+	QuantizedLanes lanes;
+
+	size_t batchVertexCount = _vertexCount & ~size_t(7);
+
+	for (size_t vertexIndex = 0; vertexIndex < batchVertexCount; vertexIndex += 8)
+	{
+		__m256 components[8];
+
+		for (u32 row = 0; row < 8; ++row)
+		{
+			components[row] = _mm256_loadu_ps(&_pRawVertices[vertexIndex + row].position[0]);
+		}
+
+		transposeVerticesAvx2(components);
+
+		for (u32 axis = 0; axis < 3; ++axis)
+		{
+			__m256 delta = _mm256_sub_ps(components[axis], positionOffset[axis]);
+			_mm256_store_si256((__m256i*)lanes.position[axis], quantizeSnormAvx2(_mm256_mul_ps(delta, positionInverseScale[axis]), 32767.0f));
+		}
+
+		__m256 nx = components[3];
+		__m256 ny = components[4];
+		__m256 nz = components[5];
+
+		__m256 normalLength = _mm256_add_ps(_mm256_add_ps(_mm256_and_ps(nx, absMask), _mm256_and_ps(ny, absMask)), _mm256_and_ps(nz, absMask));
+		__m256 bZeroNormal = _mm256_cmp_ps(normalLength, _mm256_setzero_ps(), _CMP_EQ_OQ);
+
+		nx = _mm256_div_ps(nx, normalLength);
+		ny = _mm256_div_ps(ny, normalLength);
+		nz = _mm256_div_ps(nz, normalLength);
+
+		__m256 bLowerHemisphere = _mm256_cmp_ps(nz, _mm256_setzero_ps(), _CMP_LT_OQ);
+		__m256 foldedX = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(ny, absMask)), getSignAvx2(nx));
+		__m256 foldedY = _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(nx, absMask)), getSignAvx2(ny));
+
+		__m256 encodedX = _mm256_blendv_ps(nx, foldedX, bLowerHemisphere);
+		__m256 encodedY = _mm256_blendv_ps(ny, foldedY, bLowerHemisphere);
+
+		_mm256_store_si256((__m256i*)lanes.normal[0], quantizeSnormAvx2(_mm256_andnot_ps(bZeroNormal, encodedX), 127.0f));
+		_mm256_store_si256((__m256i*)lanes.normal[1], quantizeSnormAvx2(_mm256_andnot_ps(bZeroNormal, encodedY), 127.0f));
+
+		for (u32 axis = 0; axis < 2; ++axis)
+		{
+			__m256 texCoord = _mm256_mul_ps(_mm256_sub_ps(components[kRawVertexTexCoordLane + axis], texCoordOffset[axis]), texCoordInverseScale[axis]);
+			_mm256_store_si256((__m256i*)lanes.texCoord[axis], quantizeUnormAvx2(texCoord, 65535.0f));
+		}
+
+		storeQuantizedLanes(lanes, 8u, &_pVertices[vertexIndex]);
+	}
+
+	quantizeVerticesScalar(&_pRawVertices[batchVertexCount],
+		_vertexCount - batchVertexCount, _frame, &_pVertices[batchVertexCount]);
+}
+
+static bool isAvx2Supported()
+{
+#ifdef _MSC_VER
+	i32 cpuInfo[4];
+	__cpuid(cpuInfo, 0);
+
+	if (cpuInfo[0] < 7)
+	{
+		return false;
+	}
+
+	// AVX registers have to be enabled by the OS as well.
+	__cpuid(cpuInfo, 1);
+	bool bOsAvxSupported = (cpuInfo[2] & (1 << 27)) && (cpuInfo[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6;
+
+	__cpuidex(cpuInfo, 7, 0);
+	return bOsAvxSupported && (cpuInfo[1] & (1 << 5));
+#else
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("avx2");
+#endif // _MSC_VER
+}
+#endif // QUANTIZATION_SIMD
+
+QuantizationKernel getQuantizationKernel()
+{
+#if QUANTIZATION_SIMD
+	static const QuantizationKernel kernel = isAvx2Supported() ? QuantizationKernel::Avx2 : QuantizationKernel::Sse;
+	return kernel;
+#else
+	return QuantizationKernel::Scalar;
+#endif // QUANTIZATION_SIMD
+}
+
+const char* getQuantizationKernelName(
+	QuantizationKernel _kernel)
+{
+	switch (_kernel)
+	{
+	case QuantizationKernel::Sse:
+		return "SSE";
+	case QuantizationKernel::Avx2:
+		return "AVX2";
+	default:
+		return "Scalar";
+	}
+}
+
+QuantizationFrame calculateQuantizationFrame(
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	QuantizationKernel _kernel)
+{
+	EASY_BLOCK("CalculateQuantizationFrame");
+
+	assert(_vertexCount > 0u);
+
+	f32 rangeMin[8] = { FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX };
+	f32 rangeMax[8] = { -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+	switch (_kernel)
+	{
+#if QUANTIZATION_SIMD
+	case QuantizationKernel::Sse:
+		calculateVertexRangeSse(_pVertices, _vertexCount, rangeMin, rangeMax);
+		break;
+	case QuantizationKernel::Avx2:
+		calculateVertexRangeAvx2(_pVertices, _vertexCount, rangeMin, rangeMax);
+		break;
+#endif // QUANTIZATION_SIMD
+	default:
+		calculateVertexRangeScalar(_pVertices, _vertexCount, rangeMin, rangeMax);
+		break;
+	}
+
+	v3 positionMin(rangeMin[0], rangeMin[1], rangeMin[2]);
+	v3 positionMax(rangeMax[0], rangeMax[1], rangeMax[2]);
+	v2 texCoordMin(rangeMin[kRawVertexTexCoordLane], rangeMin[kRawVertexTexCoordLane + 1]);
+	v2 texCoordMax(rangeMax[kRawVertexTexCoordLane], rangeMax[kRawVertexTexCoordLane + 1]);
+
+	return {
+		.positionOffset = 0.5f * (positionMin + positionMax),
+		.positionScale = 0.5f * (positionMax - positionMin),
+		.texCoordOffset = texCoordMin,
+		.texCoordScale = texCoordMax - texCoordMin };
+}
+
+void quantizeVertices(
+	const RawVertex* _pRawVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame,
+	Vertex* _pVertices,
+	QuantizationKernel _kernel)
+{
+	EASY_BLOCK("QuantizeVertices");
+
+	switch (_kernel)
+	{
+#if QUANTIZATION_SIMD
+	case QuantizationKernel::Sse:
+		quantizeVerticesSse(_pRawVertices, _vertexCount, _frame, _pVertices);
+		break;
+	case QuantizationKernel::Avx2:
+		quantizeVerticesAvx2(_pRawVertices, _vertexCount, _frame, _pVertices);
+		break;
+#endif // QUANTIZATION_SIMD
+	default:
+		quantizeVerticesScalar(_pRawVertices, _vertexCount, _frame, _pVertices);
+		break;
+	}
+}
+
+Vertex quantizeVertex(
+	const RawVertex& _rRawVertex,
+	QuantizationFrame _frame)
+{
+	Vertex vertex{};
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		f32 position = (_rRawVertex.position[axis] - _frame.positionOffset[axis]) * getInverseScale(_frame.positionScale[axis]);
+		vertex.position[axis] = i16(meshopt_quantizeSnorm(position, 16));
+	}
+
+	v2 normal = encodeOctahedral(v3(_rRawVertex.normal[0], _rRawVertex.normal[1], _rRawVertex.normal[2]));
+	vertex.normal[0] = i8(meshopt_quantizeSnorm(normal.x, 8));
+	vertex.normal[1] = i8(meshopt_quantizeSnorm(normal.y, 8));
+
+	for (u32 axis = 0; axis < 2; ++axis)
+	{
+		f32 texCoord = (_rRawVertex.texCoord[axis] - _frame.texCoordOffset[axis]) * getInverseScale(_frame.texCoordScale[axis]);
+		vertex.texCoord[axis] = u16(meshopt_quantizeUnorm(texCoord, 16));
+	}
+
+	return vertex;
+}
+
+RawVertex dequantizeVertex(
+	const Vertex& _rVertex,
+	QuantizationFrame _frame)
+{
+	RawVertex rawVertex{};
+
+	for (u32 axis = 0; axis < 3; ++axis)
+	{
+		rawVertex.position[axis] = _frame.positionOffset[axis] +
+			_frame.positionScale[axis] * decodeSnorm(_rVertex.position[axis], 16);
+	}
+
+	v3 normal = decodeOctahedral(v2(decodeSnorm(_rVertex.normal[0], 8), decodeSnorm(_rVertex.normal[1], 8)));
+	rawVertex.normal[0] = normal.x;
+	rawVertex.normal[1] = normal.y;
+	rawVertex.normal[2] = normal.z;
+
+	for (u32 axis = 0; axis < 2; ++axis)
+	{
+		rawVertex.texCoord[axis] = _frame.texCoordOffset[axis] +
+			_frame.texCoordScale[axis] * decodeUnorm(_rVertex.texCoord[axis], 16);
+	}
+
+	return rawVertex;
+}
+
+QuantizationError calculateQuantizationError(
+	const RawVertex* _pRawVertices,
+	const Vertex* _pVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame)
+{
+	QuantizationError error{};
+
+	for (size_t vertexIndex = 0; vertexIndex < _vertexCount; ++vertexIndex)
+	{
+		const RawVertex& rRawVertex = _pRawVertices[vertexIndex];
+		RawVertex dequantizedVertex = dequantizeVertex(_pVertices[vertexIndex], _frame);
+
+		error.position = glm::max(error.position, glm::distance(
+			v3(rRawVertex.position[0], rRawVertex.position[1], rRawVertex.position[2]),
+			v3(dequantizedVertex.position[0], dequantizedVertex.position[1], dequantizedVertex.position[2])));
+
+		v3 rawNormal = v3(rRawVertex.normal[0], rRawVertex.normal[1], rRawVertex.normal[2]);
+		if (glm::dot(rawNormal, rawNormal) > 0.0f)
+		{
+			v3 normal = v3(dequantizedVertex.normal[0], dequantizedVertex.normal[1], dequantizedVertex.normal[2]);
+			error.normal = glm::max(error.normal, glm::degrees(glm::acos(glm::clamp(glm::dot(glm::normalize(rawNormal), normal), -1.0f, 1.0f))));
+		}
+
+		error.texCoord = glm::max(error.texCoord, glm::distance(
+			v2(rRawVertex.texCoord[0], rRawVertex.texCoord[1]),
+			v2(dequantizedVertex.texCoord[0], dequantizedVertex.texCoord[1])));
+	}
+
+	return error;
+}
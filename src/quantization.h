@@ -0,0 +1,62 @@
+#pragma once
+
+// Every mesh gets its own quantization frame. Positions are stored as 16 bit snorm values relative to
+// the mesh bounding box, texture coordinates as 16 bit unorm values over their range and normals as
+// 8 bit snorm octahedral coordinates. Dequantization parameters are stored in the Mesh.
+
+struct QuantizationFrame
+{
+	v3 positionOffset{};
+	v3 positionScale{};
+	v2 texCoordOffset{};
+	v2 texCoordScale{};
+};
+
+// Largest differences between the raw and the dequantized vertices.
+struct QuantizationError
+{
+	f32 position = 0.0f;   // In mesh units.
+	f32 normal = 0.0f;     // In degrees.
+	f32 texCoord = 0.0f;   // In texture coordinate units.
+};
+
+// Batched kernels process RawVertex arrays with SSE or AVX2, picked at runtime, with a scalar fallback.
+// All kernels produce bit identical results, so baked geometry doesn't depend on the CPU it was baked on.
+enum class QuantizationKernel : u8
+{
+	Scalar,
+	Sse,
+	Avx2,
+};
+
+// Fastest kernel supported by this CPU, detected once.
+QuantizationKernel getQuantizationKernel();
+
+const char* getQuantizationKernelName(
+	QuantizationKernel _kernel);
+
+QuantizationFrame calculateQuantizationFrame(
+	const RawVertex* _pVertices,
+	size_t _vertexCount,
+	QuantizationKernel _kernel = getQuantizationKernel());
+
+void quantizeVertices(
+	const RawVertex* _pRawVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame,
+	Vertex* _pVertices,
+	QuantizationKernel _kernel = getQuantizationKernel());
+
+Vertex quantizeVertex(
+	const RawVertex& _rRawVertex,
+	QuantizationFrame _frame);
+
+RawVertex dequantizeVertex(
+	const Vertex& _rVertex,
+	QuantizationFrame _frame);
+
+QuantizationError calculateQuantizationError(
+	const RawVertex* _pRawVertices,
+	const Vertex* _pVertices,
+	size_t _vertexCount,
+	QuantizationFrame _frame);
@@ -0,0 +1,140 @@
+#include "scratch_arena.h"
+
+#include <stdlib.h>
+#include <meshoptimizer.h>
+
+// Default blocks stay allocated for the lifetime of their thread, while larger dedicated blocks are released once popped.
+const size_t kScratchBlockByteSize = 16ull << 20;
+const size_t kScratchAlignment = 16ull;
+
+struct ScratchBlock
+{
+	u8* pData = nullptr;
+	size_t byteSize = 0u;
+};
+
+struct ScratchArena;
+
+// Precedes every allocation and remembers the top of the arena before it, so popping it is just restoring that state.
+struct alignas(kScratchAlignment) ScratchHeader
+{
+	ScratchHeader* pPrevious;
+	ScratchArena* pArena;
+	size_t previousOffset;
+	u32 previousBlockIndex;
+	u32 bFreed;
+};
+
+struct ScratchArena
+{
+	std::vector<ScratchBlock> blocks;
+	u32 blockIndex = 0u;
+	size_t offset = 0u;
+	ScratchHeader* pTop = nullptr;
+
+	~ScratchArena()
+	{
+		for (ScratchBlock& rBlock : blocks)
+		{
+			free(rBlock.pData);
+		}
+	}
+};
+
+static thread_local ScratchArena tArena;
+
+static void* MESHOPTIMIZER_ALLOC_CALLCONV allocateMeshopt(
+	size_t _byteSize)
+{
+	return scratch::allocate(_byteSize);
+}
+
+static void MESHOPTIMIZER_ALLOC_CALLCONV deallocateMeshopt(
+	void* _pMemory)
+{
+	scratch::deallocate(_pMemory);
+}
+
+namespace scratch
+{
+	void initialize()
+	{
+		meshopt_setAllocator(allocateMeshopt, deallocateMeshopt);
+	}
+
+	void* allocate(
+		size_t _byteSize)
+	{
+		ScratchArena& rArena = tArena;
+		size_t requiredByteSize = sizeof(ScratchHeader) + ((_byteSize + kScratchAlignment - 1) & ~(kScratchAlignment - 1));
+
+		u32 previousBlockIndex = rArena.blockIndex;
+		size_t previousOffset = rArena.offset;
+
+		// Blocks which are too small for this allocation are skipped, and stay unused until it's popped.
+		while (true)
+		{
+			if (rArena.blockIndex == rArena.blocks.size())
+			{
+				size_t blockByteSize = glm::max(requiredByteSize, kScratchBlockByteSize);
+
+				ScratchBlock block = {
+					.pData = (u8*)malloc(blockByteSize),
+					.byteSize = blockByteSize };
+
+				assert(block.pData);
+				rArena.blocks.push_back(block);
+			}
+
+			if (rArena.offset + requiredByteSize <= rArena.blocks[rArena.blockIndex].byteSize)
+			{
+				break;
+			}
+
+			++rArena.blockIndex;
+			rArena.offset = 0u;
+		}
+
+		ScratchHeader* pHeader = (ScratchHeader*)(rArena.blocks[rArena.blockIndex].pData + rArena.offset);
+		*pHeader = {
+			.pPrevious = rArena.pTop,
+			.pArena = &rArena,
+			.previousOffset = previousOffset,
+			.previousBlockIndex = previousBlockIndex,
+			.bFreed = 0u };
+
+		rArena.offset += requiredByteSize;
+		rArena.pTop = pHeader;
+
+		return pHeader + 1;
+	}
+
+	void deallocate(
+		void* _pMemory)
+	{
+		if (!_pMemory)
+		{
+			return;
+		}
+
+		ScratchArena& rArena = tArena;
+
+		ScratchHeader* pHeader = (ScratchHeader*)_pMemory - 1;
+		assert(pHeader->pArena == &rArena && "Scratch memory has to be freed on the thread which allocated it!");
+
+		pHeader->bFreed = 1u;
+
+		while (rArena.pTop && rArena.pTop->bFreed)
+		{
+			rArena.blockIndex = rArena.pTop->previousBlockIndex;
+			rArena.offset = rArena.pTop->previousOffset;
+			rArena.pTop = rArena.pTop->pPrevious;
+		}
+
+		while (rArena.blocks.size() > rArena.blockIndex + 1u && rArena.blocks.back().byteSize > kScratchBlockByteSize)
+		{
+			free(rArena.blocks.back().pData);
+			rArena.blocks.pop_back();
+		}
+	}
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+// Per thread linear arena for short lived temporaries, like mesh processing buffers and meshoptimizer's own allocations.
+// Allocations are pushed on top of the calling thread's arena, and popped once they and everything above them are freed,
+// so the memory gets reused by the next mesh without going through the heap. Scratch memory has to be freed
+// on the thread which allocated it, so it shouldn't outlive the job it was allocated in.
+
+namespace scratch
+{
+	// Points meshoptimizer's allocator at the arena of the calling thread.
+	void initialize();
+
+	void* allocate(
+		size_t _byteSize);
+
+	void deallocate(
+		void* _pMemory);
+}
+
+template<typename T>
+struct ScratchAllocator
+{
+	using value_type = T;
+
+	ScratchAllocator() = default;
+
+	template<typename U>
+	ScratchAllocator(
+		const ScratchAllocator<U>&) {}
+
+	T* allocate(
+		size_t _count)
+	{
+		return (T*)scratch::allocate(sizeof(T) * _count);
+	}
+
+	void deallocate(
+		T* _pElements,
+		size_t _count)
+	{
+		scratch::deallocate(_pElements);
+	}
+
+	template<typename U>
+	bool operator==(
+		const ScratchAllocator<U>&) const
+	{
+		return true;
+	}
+};
+
+template<typename T>
+using ScratchVector = std::vector<T, ScratchAllocator<T>>;
@@ -8,6 +8,7 @@
 layout(binding = 0) readonly buffer Vertices { Vertex vertices[]; };
 layout(binding = 1) readonly buffer PerDrawDataVector { PerDrawData perDrawDataVector[]; };
 layout(binding = 2) readonly buffer DrawCommands { DrawCommand drawCommands[]; };
+layout(binding = 3) readonly buffer Meshes { Mesh meshes[]; };
 
 layout(location = 0) out vec3 outColor;
 
@@ -18,26 +19,45 @@ layout (push_constant) uniform block
 
 void main()
 {
-	uint drawIndex = drawCommands[gl_DrawID].drawIndex;
+	// First instance of every command is its own index, since draw ID restarts in every draw batch.
+	uint drawIndex = drawCommands[gl_InstanceIndex].drawIndex;
 	PerDrawData perDrawData = perDrawDataVector[drawIndex];
+	uint meshIndex = perDrawData.meshIndex;
+	mat4 model = decodeModel(perDrawData);
 
-	vec3 position = vec3(
-		vertices[gl_VertexIndex].position[0],
-		vertices[gl_VertexIndex].position[1],
-		vertices[gl_VertexIndex].position[2]);
+	// Vertex index already includes the vertex offset of the drawn LOD, which comes from the indirect draw command.
+	vec3 position = decodePosition(
+		ivec3(
+			vertices[gl_VertexIndex].position[0],
+			vertices[gl_VertexIndex].position[1],
+			vertices[gl_VertexIndex].position[2]),
+		vec3(
+			meshes[meshIndex].positionOffset[0],
+			meshes[meshIndex].positionOffset[1],
+			meshes[meshIndex].positionOffset[2]),
+		vec3(
+			meshes[meshIndex].positionScale[0],
+			meshes[meshIndex].positionScale[1],
+			meshes[meshIndex].positionScale[2]));
 		
-	vec4 worldPosition = perDrawData.model * vec4(position, 1.0);
+	vec4 worldPosition = model * vec4(position, 1.0);
 
-	vec3 normal = vec3(
-		int(vertices[gl_VertexIndex].normal[0]),
-		int(vertices[gl_VertexIndex].normal[1]),
-		int(vertices[gl_VertexIndex].normal[2])) / 127.0 - 1.0;
+	vec3 normal = decodeNormal(ivec2(
+		vertices[gl_VertexIndex].normal[0],
+		vertices[gl_VertexIndex].normal[1]));
 		
-	normal = mat3(perDrawData.model) * normalize(normal);
+	normal = transformNormal(model, decodeModelScale(perDrawData.scale), normal);
 
-	vec2 texCoord = vec2(
-		vertices[gl_VertexIndex].texCoord[0],
-		vertices[gl_VertexIndex].texCoord[1]);
+	vec2 texCoord = decodeTexCoord(
+		uvec2(
+			vertices[gl_VertexIndex].texCoord[0],
+			vertices[gl_VertexIndex].texCoord[1]),
+		vec2(
+			meshes[meshIndex].texCoordOffset[0],
+			meshes[meshIndex].texCoordOffset[1]),
+		vec2(
+			meshes[meshIndex].texCoordScale[0],
+			meshes[meshIndex].texCoordScale[1]));
 		
     gl_Position = perFrameData.projection * perFrameData.view * worldPosition;
 	
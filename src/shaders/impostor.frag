@@ -0,0 +1,55 @@
+#version 460
+
+#extension GL_EXT_shader_8bit_storage: require
+#extension GL_EXT_shader_16bit_storage: require
+
+#include "shader_common.h"
+
+layout(binding = 3) uniform sampler2D impostorAtlas;
+
+layout(location = 0) in vec2 inFrameCoord;
+layout(location = 1) in vec3 inWorldPosition;
+layout(location = 2) flat in vec3 inWorldDepthAxis;
+layout(location = 3) flat in mat3 inModel;
+layout(location = 6) flat in uint inMeshIndex;
+layout(location = 7) flat in vec3 inModelScale;
+
+layout(location = 0) out vec4 outColor;
+
+layout (push_constant) uniform block
+{
+	PerFrameData perFrameData;
+};
+
+void main()
+{
+	uint atlasSize = uint(textureSize(impostorAtlas, 0).x);
+	uint tileCount = atlasSize / uint(kImpostorTileSize);
+	uvec2 tile = uvec2(inMeshIndex % tileCount, inMeshIndex / tileCount);
+
+	// Coordinates are kept half a texel away from frame borders, so filtering never reads neighbouring frames.
+	vec2 frame = floor(inFrameCoord);
+	vec2 frameTexel = clamp(fract(inFrameCoord) * kImpostorFrameSize, 0.5, kImpostorFrameSize - 0.5);
+	vec2 atlasCoord = (vec2(tile * uint(kImpostorTileSize)) + frame * kImpostorFrameSize + frameTexel) / float(atlasSize);
+
+	// Uncovered texels are all zero, so filtered texels along silhouettes are divided by their coverage,
+	// which keeps the encoded normal and depth from blending with them.
+	vec4 normalDepth = textureLod(impostorAtlas, atlasCoord, 0.0);
+	if (normalDepth.w < 0.5)
+	{
+		discard;
+	}
+
+	normalDepth.xyz = normalDepth.xyz / normalDepth.w * 2.0 - 1.0;
+
+	// Baked depth moves the quad point back onto the mesh surface, so impostors depth test against regular geometry.
+	vec3 worldPosition = inWorldPosition + inWorldDepthAxis * normalDepth.z;
+	vec4 clipPosition = perFrameData.projection * perFrameData.view * vec4(worldPosition, 1.0);
+	gl_FragDepth = clipPosition.z / clipPosition.w;
+
+	vec3 normal = transformNormal(mat4(inModel), inModelScale, decodeOctahedral(normalDepth.xy));
+
+	// Meshes don't have materials, so albedo comes from the normal, same as for regular geometry.
+	float shade = dot(normal, normalize(perFrameData.cameraPosition - worldPosition));
+	outColor = vec4(shade * (0.5 + 0.5 * normal), 1.0);
+}
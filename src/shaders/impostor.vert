@@ -0,0 +1,66 @@
+#version 460
+
+#extension GL_EXT_shader_8bit_storage: require
+#extension GL_EXT_shader_16bit_storage: require
+
+#include "shader_common.h"
+
+layout(binding = 0) readonly buffer ImpostorDraws
+{
+	ImpostorDrawCommand impostorDrawCommand;
+	uint impostorDrawIndices[];
+};
+layout(binding = 1) readonly buffer PerDrawDataVector { PerDrawData perDrawDataVector[]; };
+layout(binding = 2) readonly buffer Meshes { Mesh meshes[]; };
+
+layout(location = 0) out vec2 outFrameCoord;
+layout(location = 1) out vec3 outWorldPosition;
+layout(location = 2) flat out vec3 outWorldDepthAxis;
+layout(location = 3) flat out mat3 outModel;
+layout(location = 6) flat out uint outMeshIndex;
+layout(location = 7) flat out vec3 outModelScale;
+
+layout (push_constant) uniform block
+{
+	PerFrameData perFrameData;
+};
+
+const vec2 kQuadCorners[6] = vec2[](
+	vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+	vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0));
+
+void main()
+{
+	uint drawIndex = impostorDrawIndices[gl_InstanceIndex];
+	PerDrawData perDrawData = perDrawDataVector[drawIndex];
+	uint meshIndex = perDrawData.meshIndex;
+
+	vec3 center = vec3(
+		meshes[meshIndex].center[0],
+		meshes[meshIndex].center[1],
+		meshes[meshIndex].center[2]);
+
+	float radius = meshes[meshIndex].radius;
+	mat4 decodedModel = decodeModel(perDrawData);
+	vec3 worldCenter = (decodedModel * vec4(center, 1.0)).xyz;
+
+	// The frame closest to the view direction in mesh space is drawn as a quad facing its own direction,
+	// which keeps the baked frame undistorted at the cost of popping between frames.
+	mat3 model = mat3(decodedModel);
+	vec3 viewDirection = normalize(inverse(model) * (perFrameData.cameraPosition - worldCenter));
+
+	uvec2 frame = getImpostorFrame(viewDirection);
+	mat3 frameBasis = getImpostorFrameBasis(getImpostorFrameDirection(frame));
+
+	vec2 corner = kQuadCorners[gl_VertexIndex];
+	vec3 worldPosition = worldCenter + model * (radius * (frameBasis[0] * corner.x + frameBasis[1] * corner.y));
+
+	gl_Position = perFrameData.projection * perFrameData.view * vec4(worldPosition, 1.0);
+
+	outFrameCoord = vec2(frame) + 0.5 + 0.5 * vec2(corner.x, -corner.y);
+	outWorldPosition = worldPosition;
+	outWorldDepthAxis = model * (radius * frameBasis[2]);
+	outModel = model;
+	outMeshIndex = meshIndex;
+	outModelScale = decodeModelScale(perDrawData.scale);
+}
@@ -0,0 +1,17 @@
+#version 460
+
+#extension GL_EXT_shader_8bit_storage: require
+#extension GL_EXT_shader_16bit_storage: require
+
+#include "shader_common.h"
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in float inDepth;
+
+layout(location = 0) out vec4 outNormalDepth;
+
+void main()
+{
+	// Texels without geometry keep their zero clear value, which marks them as uncovered.
+	outNormalDepth = vec4(0.5 + 0.5 * encodeOctahedral(normalize(inNormal)), 0.5 + 0.5 * inDepth, 1.0);
+}
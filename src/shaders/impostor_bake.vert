@@ -0,0 +1,48 @@
+#version 460
+
+#extension GL_EXT_shader_8bit_storage: require
+#extension GL_EXT_shader_16bit_storage: require
+
+#include "shader_common.h"
+
+layout(binding = 0) readonly buffer Vertices { Vertex vertices[]; };
+layout(binding = 1) readonly buffer Meshes { Mesh meshes[]; };
+
+layout(location = 0) out vec3 outNormal;
+layout(location = 1) out float outDepth;
+
+layout (push_constant) uniform block
+{
+	uint meshIndex;
+	uint frameIndex;
+};
+
+void main()
+{
+	Mesh mesh = meshes[meshIndex];
+
+	vec3 position = decodePosition(
+		ivec3(
+			vertices[gl_VertexIndex].position[0],
+			vertices[gl_VertexIndex].position[1],
+			vertices[gl_VertexIndex].position[2]),
+		vec3(mesh.positionOffset[0], mesh.positionOffset[1], mesh.positionOffset[2]),
+		vec3(mesh.positionScale[0], mesh.positionScale[1], mesh.positionScale[2]));
+
+	vec3 normal = decodeNormal(ivec2(
+		vertices[gl_VertexIndex].normal[0],
+		vertices[gl_VertexIndex].normal[1]));
+
+	// Every frame is an orthographic view of the mesh bounding sphere, looking against the frame direction.
+	uvec2 frame = uvec2(frameIndex % uint(kImpostorFrameCount), frameIndex / uint(kImpostorFrameCount));
+	mat3 frameBasis = getImpostorFrameBasis(getImpostorFrameDirection(frame));
+
+	vec3 center = vec3(mesh.center[0], mesh.center[1], mesh.center[2]);
+	vec3 framePosition = (position - center) * frameBasis / max(mesh.radius, 1e-6);
+
+	// Depth is reversed, so the side closer to the viewer ends up in front.
+	gl_Position = vec4(framePosition.x, -framePosition.y, 0.5 + 0.5 * framePosition.z, 1.0);
+
+	outNormal = normal;
+	outDepth = framePosition.z;
+}
@@ -7,9 +7,9 @@
 // https://www.khronos.org/registry/vulkan/specs/1.3-extensions/html/chap15.html#interfaces-resources-layout
 struct Vertex
 {
-	float16_t position[3];
-	uint8_t normal[4];
-	float16_t texCoord[2];
+	int16_t position[3];
+	int8_t normal[2];
+	uint16_t texCoord[2];
 };
 
 struct Meshlet
@@ -24,6 +24,9 @@ struct Meshlet
 
 	int8_t coneAxis[3];
 	int8_t coneCutoff;
+
+	int16_t boxMin[3];
+	int16_t boxMax[3];
 };
 
 struct PerFrameData
@@ -33,24 +36,51 @@ struct PerFrameData
 	vec4 frustumPlanes[kFrustumPlaneCount];
 	vec3 cameraPosition;
 	uint maxDrawCount;
-	float lodTransitionBase;
-	float lodTransitionStep;
 	int forcedLod;
 	uint hzbSize;
+	float lodErrorThreshold;
 	int8_t bPrepass;
 	int8_t bEnableMeshFrustumCulling;
 	int8_t bEnableMeshOcclusionCulling;
 	int8_t bEnableMeshletConeCulling;
 	int8_t bEnableMeshletFrustumCulling;
+	int8_t bEnableClusterLod;
+	int8_t bEnableGeometryStreaming;
+	int8_t bEnableBoxCulling;
+	int8_t bEnableShortIndices;
+	int8_t bEnableImpostors;
+	int8_t occlusionRetestSlice;
+	int8_t bEnableMirroredDrawBatches;
+	float impostorSizeThreshold;
+};
+
+// Node of the continuous LOD hierarchy, see Cluster in geometry.h.
+struct Cluster
+{
+	float center[3];
+	float radius;
+	float parentCenter[3];
+	float parentRadius;
+	float error;
+	float parentError;
+	uint meshletIndex;
+	uint level;
 };
 
 struct MeshLod
 {
 	uint indexCount;
 	uint firstIndex;
+	uint vertexOffset;
+	uint bShortIndices;
 
 	uint meshletOffset;
 	uint meshletCount;
+
+	uint pageOffset;
+	uint pageCount;
+
+	float error;
 };
 
 struct Mesh
@@ -59,15 +89,28 @@ struct Mesh
 
 	float center[3];
 	float radius;
+	float boxCenter[3];
+	float boxExtent[3];
+
+	float positionOffset[3];
+	float positionScale[3];
+	float texCoordOffset[2];
+	float texCoordScale[2];
+
+	uint clusterOffset;
+	uint clusterCount;
 
 	uint lodCount;
 	MeshLod lods[kMaxMeshLods];
 };
 
+// Rotation is a snorm16 quaternion and scale holds three half floats, see decodeModel.
 struct PerDrawData
 {
-	mat4 model;
+	vec3 position;
 	uint meshIndex;
+	uvec2 rotation;
+	uvec2 scale;
 };
 
 struct DrawCommand
@@ -85,4 +128,171 @@ struct DrawCommand
 	uint lodIndex;
 };
 
+// Bounding sphere of an instance hierarchy node, see InstanceNode in draw.h.
+struct InstanceNode
+{
+	float center[3];
+	float radius;
+};
+
+struct ImpostorDrawCommand
+{
+	uint vertexCount;
+	uint instanceCount;
+	uint firstVertex;
+	uint firstInstance;
+};
+
+struct PendingDrawsCommand
+{
+	uint groupCountX;
+	uint groupCountY;
+	uint groupCountZ;
+	uint drawCount;
+};
+
+// Draws with this LOD index select clusters of the mesh cluster hierarchy instead of a single LOD.
+const uint kClusterLodIndex = 0xFFFFFFFFu;
+
+// Vertex attributes are quantized relative to the mesh quantization frame.
+// Structures with 8 and 16 bit members can't be loaded as a whole, so decoding works on their members.
+vec3 decodePosition(
+	ivec3 _position,
+	vec3 _positionOffset,
+	vec3 _positionScale)
+{
+	return _positionOffset + _positionScale * max(vec3(_position) / 32767.0, -1.0);
+}
+
+// Octahedral unit vector encoding, see "A Survey of Efficient Representations for Independent Unit Vectors".
+// https://jcgt.org/published/0003/02/01/
+vec2 encodeOctahedral(
+	vec3 _vector)
+{
+	vec3 vector = _vector / (abs(_vector.x) + abs(_vector.y) + abs(_vector.z));
+	vec2 signs = mix(vec2(-1.0), vec2(1.0), greaterThanEqual(vector.xy, vec2(0.0)));
+
+	return vector.z >= 0.0 ? vector.xy : (1.0 - abs(vector.yx)) * signs;
+}
+
+vec3 decodeOctahedral(
+	vec2 _encoded)
+{
+	vec3 vector = vec3(_encoded, 1.0 - abs(_encoded.x) - abs(_encoded.y));
+	float t = max(-vector.z, 0.0);
+	vector.xy += mix(vec2(t), vec2(-t), greaterThanEqual(vector.xy, vec2(0.0)));
+
+	return normalize(vector);
+}
+
+vec3 decodeNormal(
+	ivec2 _normal)
+{
+	return decodeOctahedral(max(vec2(_normal) / 127.0, -1.0));
+}
+
+vec2 decodeTexCoord(
+	uvec2 _texCoord,
+	vec2 _texCoordOffset,
+	vec2 _texCoordScale)
+{
+	return _texCoordOffset + _texCoordScale * vec2(_texCoord) / 65535.0;
+}
+
+vec3 decodeModelScale(
+	uvec2 _scale)
+{
+	return vec3(unpackHalf2x16(_scale.x), unpackHalf2x16(_scale.y).x);
+}
+
+// Largest axis scale, which scales mesh space radii and errors.
+float getMaxModelScale(
+	PerDrawData _perDrawData)
+{
+	vec3 scale = abs(decodeModelScale(_perDrawData.scale));
+	return max(max(scale.x, scale.y), scale.z);
+}
+
+// Shaders sharing a draw across a workgroup decode it once into shared memory.
+mat4 decodeModel(
+	PerDrawData _perDrawData)
+{
+	vec4 q = normalize(vec4(
+		unpackSnorm2x16(_perDrawData.rotation.x),
+		unpackSnorm2x16(_perDrawData.rotation.y)));
+
+	vec3 scale = decodeModelScale(_perDrawData.scale);
+
+	return mat4(
+		vec4(scale.x * vec3(1.0 - 2.0 * (q.y * q.y + q.z * q.z), 2.0 * (q.x * q.y + q.w * q.z), 2.0 * (q.x * q.z - q.w * q.y)), 0.0),
+		vec4(scale.y * vec3(2.0 * (q.x * q.y - q.w * q.z), 1.0 - 2.0 * (q.x * q.x + q.z * q.z), 2.0 * (q.y * q.z + q.w * q.x)), 0.0),
+		vec4(scale.z * vec3(2.0 * (q.x * q.z + q.w * q.y), 2.0 * (q.y * q.z - q.w * q.x), 1.0 - 2.0 * (q.x * q.x + q.y * q.y)), 0.0),
+		vec4(_perDrawData.position, 1.0));
+}
+
+// Inverse transpose of the model is its rotation times inverse scale, so it's the model applied to the normal divided by the squared scale.
+vec3 transformNormal(
+	mat4 _model,
+	vec3 _scale,
+	vec3 _normal)
+{
+	return normalize(mat3(_model) * (_normal / (_scale * _scale)));
+}
+
+// Impostor frames cover the whole sphere of view directions, laid out on an octahedral grid.
+vec3 getImpostorFrameDirection(
+	uvec2 _frame)
+{
+	return decodeOctahedral((vec2(_frame) + 0.5) / float(kImpostorFrameCount) * 2.0 - 1.0);
+}
+
+uvec2 getImpostorFrame(
+	vec3 _direction)
+{
+	vec2 encoded = 0.5 + 0.5 * encodeOctahedral(_direction);
+	return min(uvec2(encoded * float(kImpostorFrameCount)), uvec2(kImpostorFrameCount - 1));
+}
+
+// Right, up and view direction of a frame, shared by baking and drawing so both agree on the frame orientation.
+mat3 getImpostorFrameBasis(
+	vec3 _direction)
+{
+	vec3 upReference = abs(_direction.y) > 0.999 ? vec3(0.0, 0.0, 1.0) : vec3(0.0, 1.0, 0.0);
+	vec3 right = normalize(cross(upReference, _direction));
+
+	return mat3(right, cross(_direction, right), _direction);
+}
+
+// 2D Polyhedral Bounds of a Clipped, Perspective-Projected 3D Sphere
+// https://jcgt.org/published/0002/02/05/
+bool tryCalculateSphereBounds(
+	vec3 _center,
+	float _radius,
+	float _zNear,
+	float _P00,
+	float _P11,
+	out vec4 _AABB)
+{
+	if (-_center.z < _radius + _zNear)
+	{
+		return false;
+	}
+
+	vec2 centerXZ = -_center.xz;
+	vec2 vX = vec2(sqrt(dot(centerXZ, centerXZ) - _radius * _radius), _radius);
+	vec2 minX = mat2(vX.x, vX.y, -vX.y, vX.x) * centerXZ;
+	vec2 maxX = mat2(vX.x, -vX.y, vX.y, vX.x) * centerXZ;
+
+	vec2 centerYZ = -_center.yz;
+	vec2 vY = vec2(sqrt(dot(centerYZ, centerYZ) - _radius * _radius), _radius);
+	vec2 minY = mat2(vY.x, vY.y, -vY.y, vY.x) * centerYZ;
+	vec2 maxY = mat2(vY.x, -vY.y, vY.y, vY.x) * centerYZ;
+
+	_AABB = 0.5 - 0.5 * vec4(
+		minX.x / minX.y * _P00, minY.x / minY.y * _P11,
+		maxX.x / maxX.y * _P00, maxY.x / maxY.y * _P11);
+
+	return true;
+}
+
 #endif // SHADER_COMMON_H
@@ -10,4 +10,31 @@ const int kMaxTrianglesPerMeshlet = 124;
 const int kMaxMeshLods = 12;
 const int kFrustumPlaneCount = 5;
 
+// Streaming pages hold one task shader workgroup worth of meshlets, with enough room for all of their vertices.
+const int kStreamingPageMeshletCount = kShaderGroupSizeNV;
+const int kStreamingPageVertexCount = kStreamingPageMeshletCount * kMaxVerticesPerMeshlet;
+const int kStreamingPageTriangleByteCount = kStreamingPageMeshletCount * ((3 * kMaxTrianglesPerMeshlet + 3) & ~3);
+
+// Geometry streaming feedback bits, written by culling for every mesh LOD.
+const int kStreamingLodRequested = 1;
+const int kStreamingLodUsed = 2;
+
+// Traditional pipeline draws LODs with 32 and 16 bit indices in separate indirect batches, since each needs its own index buffer,
+// and mirrored draws in batches of their own, drawn with the opposite front face. Batch index is a combination of these bits.
+const int kDrawBatchCount = 4;
+const int kShortIndexDrawBatch = 1;
+const int kMirroredDrawBatch = 2;
+
+// Impostors are baked from an octahedral grid of view directions, with every mesh getting a tile of the impostor atlas.
+const int kImpostorFrameCount = 8;
+const int kImpostorFrameSize = 32;
+const int kImpostorTileSize = kImpostorFrameCount * kImpostorFrameSize;
+const int kMaxImpostorAtlasSize = 4096; // 256 tiles, 64 MB with 32 bit texels.
+
+// Instance hierarchy nodes bound one workgroup worth of children, leaf nodes bound draws and top nodes bound leaf nodes.
+const int kInstanceNodeChildCount = kShaderGroupSizeNV;
+
+// Draws drawn by the prepass are retested against the new HZB in slices, one slice per frame.
+const int kOcclusionRetestSliceCount = 4;
+
 #endif // SHADER_CONSTANTS_H
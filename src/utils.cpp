@@ -1,6 +1,18 @@
 #include "utils.h"
 
 #include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif // _WIN32
 
 std::vector<char> readFile(
 	const char* _pFilePath)
@@ -19,6 +31,97 @@ std::vector<char> readFile(
 	return fileContents;
 }
 
+bool tryMapFile(
+	const char* _pFilePath,
+	MappedFile& _rMappedFile)
+{
+	_rMappedFile = {};
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(_pFilePath, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0u, 0u, nullptr);
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	void* pData = MapViewOfFile(mapping, FILE_MAP_READ, 0u, 0u, 0u);
+	if (pData == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	_rMappedFile.pData = (const u8*)pData;
+	_rMappedFile.byteSize = size_t(fileSize.QuadPart);
+	_rMappedFile.fileHandle = file;
+	_rMappedFile.mappingHandle = mapping;
+#else
+	i32 file = open(_pFilePath, O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(file, &fileStat) != 0 || fileStat.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	void* pData = mmap(nullptr, size_t(fileStat.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+	// Mapping keeps its own reference to the file.
+	close(file);
+
+	if (pData == MAP_FAILED)
+	{
+		return false;
+	}
+
+	_rMappedFile.pData = (const u8*)pData;
+	_rMappedFile.byteSize = size_t(fileStat.st_size);
+#endif // _WIN32
+
+	return true;
+}
+
+void unmapFile(
+	MappedFile& _rMappedFile)
+{
+	if (_rMappedFile.pData == nullptr)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(_rMappedFile.pData);
+	CloseHandle(_rMappedFile.mappingHandle);
+	CloseHandle(_rMappedFile.fileHandle);
+#else
+	munmap((void*)_rMappedFile.pData, _rMappedFile.byteSize);
+#endif // _WIN32
+
+	_rMappedFile = {};
+}
+
 m4 getInfinitePerspectiveMatrix(
 	f32 _fov,
 	f32 _aspect,
@@ -32,6 +135,51 @@ m4 getInfinitePerspectiveMatrix(
 		0.0f, 0.0f, _near, 0.0f);
 }
 
+// https://github.com/aappleby/smhasher/blob/master/src/MurmurHash2.cpp
+u64 calculateHash64(
+	const void* _pData,
+	size_t _byteSize,
+	u64 _seed)
+{
+	const u64 kMultiplier = 0xc6a4a7935bd1e995ull;
+	const i32 kShift = 47;
+
+	u64 hash = _seed ^ (_byteSize * kMultiplier);
+
+	const u8* pBytes = (const u8*)_pData;
+	const u8* pBlocksEnd = pBytes + (_byteSize & ~size_t(7));
+
+	for (; pBytes != pBlocksEnd; pBytes += 8)
+	{
+		u64 block;
+		memcpy(&block, pBytes, sizeof(block));
+
+		block *= kMultiplier;
+		block ^= block >> kShift;
+		block *= kMultiplier;
+
+		hash ^= block;
+		hash *= kMultiplier;
+	}
+
+	size_t tailByteCount = _byteSize & 7;
+	if (tailByteCount > 0)
+	{
+		for (size_t byteIndex = 0; byteIndex < tailByteCount; ++byteIndex)
+		{
+			hash ^= u64(pBytes[byteIndex]) << (8 * byteIndex);
+		}
+
+		hash *= kMultiplier;
+	}
+
+	hash ^= hash >> kShift;
+	hash *= kMultiplier;
+	hash ^= hash >> kShift;
+
+	return hash;
+}
+
 u32 divideRoundingUp(
 	u32 _dividend,
 	u32 _divisor)
@@ -3,11 +3,32 @@
 std::vector<char> readFile(
 	const char* _pFilePath);
 
+struct MappedFile
+{
+	const u8* pData = nullptr;
+	size_t byteSize = 0u;
+	void* fileHandle = nullptr;
+	void* mappingHandle = nullptr;
+};
+
+bool tryMapFile(
+	const char* _pFilePath,
+	MappedFile& _rMappedFile);
+
+void unmapFile(
+	MappedFile& _rMappedFile);
+
 m4 getInfinitePerspectiveMatrix(
 	f32 _fov,
 	f32 _aspect,
 	f32 _near);
 
+// MurmurHash64A, fast enough to hash whole geometry streams.
+u64 calculateHash64(
+	const void* _pData,
+	size_t _byteSize,
+	u64 _seed = 0ull);
+
 u32 divideRoundingUp(
 	u32 _dividend,
 	u32 _divisor);
@@ -0,0 +1,165 @@
+#include "core/device.h"
+#include "core/buffer.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "utils.h"
+#include "geometry_cache.h"
+#include "mesh_import.h"
+#include "job_system.h"
+#include "scratch_arena.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <filesystem>
+#include <atomic>
+
+// Offline geometry baking, runs the whole mesh import pipeline without creating a Vulkan device.
+// Usage: vulkanizer_bake [-o <output directory>] [--parallel-lods] [--cluster-hierarchy] [--streaming-pages] [--chunk-triangles <count>] [--compact-lod-vertices] [--sloppy-lods] [--position-only-lods] [--meshlet-cone-weight <weight>] [--compress] [--verbose] <mesh paths...>
+
+static void printUsage()
+{
+	printf("Usage: vulkanizer_bake [-o <output directory>] [--parallel-lods] [--cluster-hierarchy] [--streaming-pages] [--chunk-triangles <count>] [--compact-lod-vertices] [--sloppy-lods] [--position-only-lods] [--meshlet-cone-weight <weight>] [--compress] [--verbose] <mesh paths...>\n");
+}
+
+i32 main(
+	i32 _argc,
+	const char** _argv)
+{
+	EASY_MAIN_THREAD;
+
+	const char* pOutputDirectory = nullptr;
+	MeshProcessingDesc processingDesc{};
+	bool bCompress = false;
+	std::vector<const char*> meshPaths;
+
+	for (i32 argIndex = 1; argIndex < _argc; ++argIndex)
+	{
+		if (strcmp(_argv[argIndex], "-o") == 0)
+		{
+			if (argIndex + 1 >= _argc)
+			{
+				printUsage();
+				return 1;
+			}
+
+			pOutputDirectory = _argv[++argIndex];
+		}
+		else if (strcmp(_argv[argIndex], "--parallel-lods") == 0)
+		{
+			processingDesc.bParallelLods = true;
+		}
+		else if (strcmp(_argv[argIndex], "--cluster-hierarchy") == 0)
+		{
+			processingDesc.bClusterHierarchy = true;
+		}
+		else if (strcmp(_argv[argIndex], "--streaming-pages") == 0)
+		{
+			processingDesc.bStreamingPages = true;
+		}
+		else if (strcmp(_argv[argIndex], "--chunk-triangles") == 0)
+		{
+			if (argIndex + 1 >= _argc)
+			{
+				printUsage();
+				return 1;
+			}
+
+			processingDesc.chunkTriangleCount = u32(atoi(_argv[++argIndex]));
+		}
+		else if (strcmp(_argv[argIndex], "--compact-lod-vertices") == 0)
+		{
+			processingDesc.bCompactLodVertices = true;
+		}
+		else if (strcmp(_argv[argIndex], "--sloppy-lods") == 0)
+		{
+			processingDesc.bSloppyLods = true;
+		}
+		else if (strcmp(_argv[argIndex], "--position-only-lods") == 0)
+		{
+			processingDesc.bPositionOnlyLods = true;
+		}
+		else if (strcmp(_argv[argIndex], "--meshlet-cone-weight") == 0)
+		{
+			if (argIndex + 1 >= _argc)
+			{
+				printUsage();
+				return 1;
+			}
+
+			processingDesc.meshletConeWeight = glm::clamp(f32(atof(_argv[++argIndex])), 0.0f, 1.0f);
+		}
+		else if (strcmp(_argv[argIndex], "--compress") == 0)
+		{
+			bCompress = true;
+		}
+		else if (strcmp(_argv[argIndex], "--verbose") == 0)
+		{
+			processingDesc.bVerbose = true;
+		}
+		else
+		{
+			meshPaths.push_back(_argv[argIndex]);
+		}
+	}
+
+	if (meshPaths.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	if (processingDesc.bStreamingPages && processingDesc.chunkTriangleCount > 0u)
+	{
+		fprintf(stderr, "Streamed geometry can't be split into spatial chunks.\n");
+		return 1;
+	}
+
+	if (pOutputDirectory)
+	{
+		std::error_code error;
+		std::filesystem::create_directories(pOutputDirectory, error);
+	}
+
+	for (const char* pMeshPath : meshPaths)
+	{
+		if (!std::filesystem::exists(pMeshPath))
+		{
+			fprintf(stderr, "Mesh %s doesn't exist.\n", pMeshPath);
+			return 1;
+		}
+	}
+
+	jobs::initialize();
+	scratch::initialize();
+
+	u32 processingHash = calculateProcessingHash(processingDesc);
+
+	std::atomic<bool> bFailed = false;
+
+	jobs::parallelFor(u32(meshPaths.size()), [&](u32 _meshIndex)
+		{
+			const char* pMeshPath = meshPaths[_meshIndex];
+
+			std::string cachePath = getGeometryCachePath(pOutputDirectory ?
+				(std::filesystem::path(pOutputDirectory) / std::filesystem::path(pMeshPath).filename()).string().c_str() :
+				pMeshPath);
+
+			Geometry geometry{};
+			importMesh(geometry, pMeshPath, processingDesc);
+
+			if (!saveGeometryCache(cachePath.c_str(), pMeshPath, processingHash, geometry, bCompress))
+			{
+				fprintf(stderr, "Failed to write %s.\n", cachePath.c_str());
+				bFailed = true;
+				return;
+			}
+
+			printf("Baked %s: %zu vertices, %zu indices, %zu meshlets, %zu meshes, %u LODs.\n", cachePath.c_str(),
+				geometry.vertices.size(), geometry.indices.size(), geometry.meshlets.size(), geometry.meshes.size(), geometry.meshes[0].lodCount);
+		});
+
+	jobs::terminate();
+
+	return bFailed ? 1 : 0;
+}
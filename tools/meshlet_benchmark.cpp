@@ -0,0 +1,345 @@
+#include "core/device.h"
+#include "core/buffer.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "mesh_import.h"
+#include "bounds.h"
+
+#include <meshoptimizer.h>
+#include <string.h>
+#include <stdlib.h>
+#include <float.h>
+
+// Builds meshlets of OBJ meshes for every combination of cone weight and meshlet limits, and reports their quality,
+// along with cone and frustum cull rates simulated from cameras placed around the mesh, looking at its center.
+// Usage: vulkanizer_meshlet_benchmark [-w <cone weights>] [-v <max vertices>] [-t <max triangles>] [-c <camera count>] [-d <camera distance>] <mesh paths...>
+// Lists are comma separated, and camera distance is relative to the mesh bounding sphere radius.
+
+static void printUsage()
+{
+	printf("Usage: vulkanizer_meshlet_benchmark [-w <cone weights>] [-v <max vertices>] [-t <max triangles>] [-c <camera count>] [-d <camera distance>] <mesh paths...>\n");
+}
+
+const f32 kCameraFov = 45.0f;
+const f32 kCameraAspect = 16.0f / 9.0f;
+
+struct MeshletConfig
+{
+	f32 coneWeight = 0.0f;
+	u32 maxVertices = 0u;
+	u32 maxTriangles = 0u;
+};
+
+struct MeshletMetrics
+{
+	u32 meshletCount = 0u;
+	f64 averageVertexCount = 0.0;
+	f64 averageTriangleCount = 0.0;
+	f64 averageRadius = 0.0;        // Relative to the mesh bounding sphere radius.
+	f64 averageConeSpread = 0.0;    // Half angle of the normal cone in degrees, over meshlets which can be cone culled.
+	f64 openConeRate = 0.0;         // Meshlets whose normals spread too much to ever be cone culled.
+	f64 coneCullRate = 0.0;         // Culled triangles over all cameras.
+	f64 frustumCullRate = 0.0;
+	f64 cullRate = 0.0;
+};
+
+static bool tryParseList(
+	const char* _pList,
+	std::vector<f32>& _rValues)
+{
+	_rValues.clear();
+
+	for (const char* pValue = _pList; *pValue != '\0';)
+	{
+		char* pEnd;
+		_rValues.push_back(strtof(pValue, &pEnd));
+
+		if (pEnd == pValue || (*pEnd != ',' && *pEnd != '\0'))
+		{
+			return false;
+		}
+
+		pValue = *pEnd == ',' ? pEnd + 1 : pEnd;
+	}
+
+	return !_rValues.empty();
+}
+
+// Cameras are spread evenly over a sphere around the mesh with a Fibonacci lattice.
+static std::vector<v3> getCameraPositions(
+	BoundingSphere _meshSphere,
+	u32 _cameraCount,
+	f32 _cameraDistance)
+{
+	std::vector<v3> cameraPositions(_cameraCount);
+
+	for (u32 cameraIndex = 0; cameraIndex < _cameraCount; ++cameraIndex)
+	{
+		f32 y = 1.0f - 2.0f * (f32(cameraIndex) + 0.5f) / f32(_cameraCount);
+		f32 ringRadius = glm::sqrt(glm::max(1.0f - y * y, 0.0f));
+		f32 angle = 2.39996323f * f32(cameraIndex);
+
+		v3 direction = v3(ringRadius * glm::cos(angle), y, ringRadius * glm::sin(angle));
+		cameraPositions[cameraIndex] = _meshSphere.center + _cameraDistance * _meshSphere.radius * direction;
+	}
+
+	return cameraPositions;
+}
+
+// Side and near planes are extracted from the view projection matrix, same as the renderer culls with kFrustumPlaneCount planes.
+static void getFrustumPlanes(
+	v3 _cameraPosition,
+	v3 _target,
+	v4* _pFrustumPlanes)
+{
+	v3 up = glm::abs(glm::normalize(_target - _cameraPosition).y) > 0.999f ? v3(0.0f, 0.0f, 1.0f) : v3(0.0f, 1.0f, 0.0f);
+	m4 viewProjection = glm::perspective(glm::radians(kCameraFov), kCameraAspect, 0.01f, 1000.0f) *
+		glm::lookAt(_cameraPosition, _target, up);
+
+	m4 rows = glm::transpose(viewProjection);
+
+	_pFrustumPlanes[0] = rows[3] + rows[0];
+	_pFrustumPlanes[1] = rows[3] - rows[0];
+	_pFrustumPlanes[2] = rows[3] + rows[1];
+	_pFrustumPlanes[3] = rows[3] - rows[1];
+	_pFrustumPlanes[4] = rows[3] + rows[2];
+
+	for (u32 planeIndex = 0; planeIndex < kFrustumPlaneCount; ++planeIndex)
+	{
+		_pFrustumPlanes[planeIndex] /= glm::length(v3(_pFrustumPlanes[planeIndex]));
+	}
+}
+
+static MeshletMetrics measureMeshlets(
+	MeshletConfig _config,
+	std::vector<RawVertex>& _rVertices,
+	std::vector<u32>& _rIndices,
+	BoundingSphere _meshSphere,
+	const std::vector<v3>& _rCameraPositions)
+{
+	size_t maxMeshlets = meshopt_buildMeshletsBound(_rIndices.size(), _config.maxVertices, _config.maxTriangles);
+	std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+	std::vector<u32> meshletVertices(maxMeshlets * _config.maxVertices);
+	std::vector<u8> meshletTriangles(maxMeshlets * _config.maxTriangles * 3);
+
+	meshlets.resize(meshopt_buildMeshlets(meshlets.data(), meshletVertices.data(), meshletTriangles.data(), _rIndices.data(), _rIndices.size(),
+		&_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex), _config.maxVertices, _config.maxTriangles, _config.coneWeight));
+
+	// Culling works on the same data the task shader gets, Ritter spheres and 8 bit cones.
+	std::vector<BoundingSphere> spheres(meshlets.size());
+	std::vector<v4> cones(meshlets.size());
+
+	MeshletMetrics metrics = { .meshletCount = u32(meshlets.size()) };
+	u32 closedConeCount = 0u;
+	u64 triangleCount = 0ull;
+
+	for (size_t meshletIndex = 0; meshletIndex < meshlets.size(); ++meshletIndex)
+	{
+		meshopt_Meshlet& rMeshlet = meshlets[meshletIndex];
+
+		meshopt_Bounds bounds = meshopt_computeMeshletBounds(&meshletVertices[rMeshlet.vertex_offset],
+			&meshletTriangles[rMeshlet.triangle_offset], rMeshlet.triangle_count,
+			&_rVertices[0].position[0], _rVertices.size(), sizeof(RawVertex));
+
+		spheres[meshletIndex] = calculateBoundingSphere(&_rVertices[0].position[0], sizeof(RawVertex),
+			&meshletVertices[rMeshlet.vertex_offset], rMeshlet.vertex_count);
+
+		cones[meshletIndex] = v4(bounds.cone_axis_s8[0], bounds.cone_axis_s8[1], bounds.cone_axis_s8[2], bounds.cone_cutoff_s8) / 127.0f;
+
+		metrics.averageVertexCount += rMeshlet.vertex_count;
+		metrics.averageTriangleCount += rMeshlet.triangle_count;
+		metrics.averageRadius += spheres[meshletIndex].radius;
+		triangleCount += rMeshlet.triangle_count;
+
+		// Cutoff is the sine of the normal cone half angle, and it saturates once normals spread over a hemisphere.
+		if (bounds.cone_cutoff_s8 < 127)
+		{
+			metrics.averageConeSpread += glm::degrees(glm::asin(glm::clamp(bounds.cone_cutoff, -1.0f, 1.0f)));
+			++closedConeCount;
+		}
+	}
+
+	u64 coneCulledTriangleCount = 0ull;
+	u64 frustumCulledTriangleCount = 0ull;
+	u64 culledTriangleCount = 0ull;
+
+	for (v3 cameraPosition : _rCameraPositions)
+	{
+		v4 frustumPlanes[kFrustumPlaneCount];
+		getFrustumPlanes(cameraPosition, _meshSphere.center, frustumPlanes);
+
+		for (size_t meshletIndex = 0; meshletIndex < meshlets.size(); ++meshletIndex)
+		{
+			BoundingSphere sphere = spheres[meshletIndex];
+			v4 cone = cones[meshletIndex];
+
+			bool bConeCulled = glm::dot(glm::normalize(sphere.center - cameraPosition), v3(cone)) >= cone.w;
+			bool bFrustumCulled = false;
+
+			for (u32 planeIndex = 0; planeIndex < kFrustumPlaneCount; ++planeIndex)
+			{
+				bFrustumCulled = bFrustumCulled || glm::dot(v4(sphere.center, 1.0f), frustumPlanes[planeIndex]) + sphere.radius < 0.0f;
+			}
+
+			u32 meshletTriangleCount = meshlets[meshletIndex].triangle_count;
+			coneCulledTriangleCount += bConeCulled ? meshletTriangleCount : 0u;
+			frustumCulledTriangleCount += bFrustumCulled ? meshletTriangleCount : 0u;
+			culledTriangleCount += bConeCulled || bFrustumCulled ? meshletTriangleCount : 0u;
+		}
+	}
+
+	f64 meshletCount = glm::max(f64(meshlets.size()), 1.0);
+	f64 viewedTriangleCount = glm::max(f64(triangleCount) * f64(_rCameraPositions.size()), 1.0);
+
+	metrics.averageVertexCount /= meshletCount;
+	metrics.averageTriangleCount /= meshletCount;
+	metrics.averageRadius /= meshletCount * glm::max(f64(_meshSphere.radius), 1e-9);
+	metrics.averageConeSpread /= glm::max(f64(closedConeCount), 1.0);
+	metrics.openConeRate = 1.0 - f64(closedConeCount) / meshletCount;
+	metrics.coneCullRate = f64(coneCulledTriangleCount) / viewedTriangleCount;
+	metrics.frustumCullRate = f64(frustumCulledTriangleCount) / viewedTriangleCount;
+	metrics.cullRate = f64(culledTriangleCount) / viewedTriangleCount;
+
+	return metrics;
+}
+
+i32 main(
+	i32 _argc,
+	const char** _argv)
+{
+	std::vector<f32> coneWeights = { 0.0f, 0.25f, 0.5f, 0.7f, 1.0f };
+	std::vector<f32> maxVertexCounts = { f32(kMaxVerticesPerMeshlet) };
+	std::vector<f32> maxTriangleCounts = { f32(kMaxTrianglesPerMeshlet) };
+	u32 cameraCount = 64u;
+	f32 cameraDistance = 1.5f;
+	std::vector<const char*> meshPaths;
+
+	for (i32 argIndex = 1; argIndex < _argc; ++argIndex)
+	{
+		bool bValid = true;
+
+		if (strcmp(_argv[argIndex], "-w") == 0)
+		{
+			bValid = argIndex + 1 < _argc && tryParseList(_argv[++argIndex], coneWeights);
+		}
+		else if (strcmp(_argv[argIndex], "-v") == 0)
+		{
+			bValid = argIndex + 1 < _argc && tryParseList(_argv[++argIndex], maxVertexCounts);
+		}
+		else if (strcmp(_argv[argIndex], "-t") == 0)
+		{
+			bValid = argIndex + 1 < _argc && tryParseList(_argv[++argIndex], maxTriangleCounts);
+		}
+		else if (strcmp(_argv[argIndex], "-c") == 0)
+		{
+			bValid = argIndex + 1 < _argc;
+
+			if (bValid)
+			{
+				cameraCount = u32(glm::max(atoi(_argv[++argIndex]), 1));
+			}
+		}
+		else if (strcmp(_argv[argIndex], "-d") == 0)
+		{
+			bValid = argIndex + 1 < _argc;
+
+			if (bValid)
+			{
+				cameraDistance = glm::max(f32(atof(_argv[++argIndex])), 0.0f);
+			}
+		}
+		else
+		{
+			meshPaths.push_back(_argv[argIndex]);
+		}
+
+		if (!bValid)
+		{
+			printUsage();
+			return 1;
+		}
+	}
+
+	if (meshPaths.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	// Limits are the ones meshoptimizer supports, with triangle counts kept divisible by 4 for packed triangle writes.
+	std::vector<MeshletConfig> configs;
+
+	for (f32 maxVertexCount : maxVertexCounts)
+	{
+		for (f32 maxTriangleCount : maxTriangleCounts)
+		{
+			for (f32 coneWeight : coneWeights)
+			{
+				MeshletConfig config = {
+					.coneWeight = glm::clamp(coneWeight, 0.0f, 1.0f),
+					.maxVertices = glm::clamp(u32(maxVertexCount), 3u, 255u),
+					.maxTriangles = glm::clamp(u32(maxTriangleCount) & ~3u, 4u, 512u) };
+
+				configs.push_back(config);
+			}
+		}
+	}
+
+	printf("%u cameras at %.2f mesh radii, limits marked with * don't match the shader limits of %u vertices and %u triangles.\n",
+		cameraCount, cameraDistance, kMaxVerticesPerMeshlet, kMaxTrianglesPerMeshlet);
+
+	for (const char* pMeshPath : meshPaths)
+	{
+		std::vector<RawVertex> vertices;
+		std::vector<u32> indices;
+
+		if (!readObjMesh(pMeshPath, vertices, indices))
+		{
+			fprintf(stderr, "Failed to read %s.\n", pMeshPath);
+			return 1;
+		}
+
+		// Meshes are optimized like import optimizes them, so meshlets are built over the same triangle order.
+		optimizeMeshData(vertices, indices);
+
+		BoundingSphere meshSphere = calculateBoundingSphere(&vertices[0].position[0], sizeof(RawVertex), nullptr, vertices.size());
+		std::vector<v3> cameraPositions = getCameraPositions(meshSphere, cameraCount, cameraDistance);
+
+		printf("%s, %zu vertices, %zu triangles:\n", pMeshPath, vertices.size(), indices.size() / 3);
+		printf("  cone  verts  tris  meshlets  avg verts  avg tris  radius  cone spread  open cones  cone cull  frustum cull  total cull\n");
+
+		u32 bestConfigIndex = 0u;
+		MeshletMetrics bestMetrics{};
+
+		for (u32 configIndex = 0; configIndex < configs.size(); ++configIndex)
+		{
+			MeshletConfig config = configs[configIndex];
+			MeshletMetrics metrics = measureMeshlets(config, vertices, indices, meshSphere, cameraPositions);
+
+			bool bShaderLimits = config.maxVertices <= kMaxVerticesPerMeshlet && config.maxTriangles <= kMaxTrianglesPerMeshlet;
+
+			printf("  %4.2f %5u%c %4u%c %9u %10.1f %9.1f %6.2f%% %10.1f deg %10.1f%% %9.1f%% %12.1f%% %10.1f%%\n",
+				config.coneWeight, config.maxVertices, bShaderLimits ? ' ' : '*', config.maxTriangles, bShaderLimits ? ' ' : '*',
+				metrics.meshletCount, metrics.averageVertexCount, metrics.averageTriangleCount, 100.0 * metrics.averageRadius,
+				metrics.averageConeSpread, 100.0 * metrics.openConeRate, 100.0 * metrics.coneCullRate,
+				100.0 * metrics.frustumCullRate, 100.0 * metrics.cullRate);
+
+			// Culled triangles are what culling throughput is about, while fewer meshlets mean less culling work on ties.
+			bool bBetter = configIndex == 0u || metrics.cullRate > bestMetrics.cullRate ||
+				(metrics.cullRate == bestMetrics.cullRate && metrics.meshletCount < bestMetrics.meshletCount);
+
+			if (bBetter)
+			{
+				bestConfigIndex = configIndex;
+				bestMetrics = metrics;
+			}
+		}
+
+		MeshletConfig bestConfig = configs[bestConfigIndex];
+		printf("  Best: cone weight %.2f, %u vertices, %u triangles, %.1f%% triangles culled.\n",
+			bestConfig.coneWeight, bestConfig.maxVertices, bestConfig.maxTriangles, 100.0 * bestMetrics.cullRate);
+	}
+
+	return 0;
+}
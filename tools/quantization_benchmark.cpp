@@ -0,0 +1,112 @@
+#include "core/device.h"
+#include "core/buffer.h"
+
+#include "shaders/shader_constants.h"
+#include "geometry.h"
+#include "mesh_import.h"
+#include "quantization.h"
+
+#include <string.h>
+#include <stdlib.h>
+#include <float.h>
+#include <chrono>
+
+// Times every quantization kernel supported by this CPU on OBJ meshes, and checks that they all produce the same vertices.
+// Usage: vulkanizer_quantization_benchmark [-i <iterations>] <mesh paths...>
+
+static void printUsage()
+{
+	printf("Usage: vulkanizer_quantization_benchmark [-i <iterations>] <mesh paths...>\n");
+}
+
+i32 main(
+	i32 _argc,
+	const char** _argv)
+{
+	u32 iterationCount = 20u;
+	std::vector<const char*> meshPaths;
+
+	for (i32 argIndex = 1; argIndex < _argc; ++argIndex)
+	{
+		if (strcmp(_argv[argIndex], "-i") == 0)
+		{
+			if (argIndex + 1 >= _argc)
+			{
+				printUsage();
+				return 1;
+			}
+
+			iterationCount = u32(glm::max(atoi(_argv[++argIndex]), 1));
+		}
+		else
+		{
+			meshPaths.push_back(_argv[argIndex]);
+		}
+	}
+
+	if (meshPaths.empty())
+	{
+		printUsage();
+		return 1;
+	}
+
+	QuantizationKernel supportedKernel = getQuantizationKernel();
+	printf("Fastest supported kernel: %s, best of %u iterations.\n", getQuantizationKernelName(supportedKernel), iterationCount);
+
+	bool bMismatch = false;
+
+	for (const char* pMeshPath : meshPaths)
+	{
+		std::vector<RawVertex> rawVertices;
+		std::vector<u32> indices;
+
+		if (!readObjMesh(pMeshPath, rawVertices, indices))
+		{
+			fprintf(stderr, "Failed to read %s.\n", pMeshPath);
+			return 1;
+		}
+
+		// Vertices are quantized in the order import quantizes them, after vertex fetch optimization.
+		optimizeMeshData(rawVertices, indices);
+
+		printf("%s, %zu vertices:\n", pMeshPath, rawVertices.size());
+
+		std::vector<Vertex> referenceVertices;
+		f64 scalarTime = 0.0;
+
+		for (u32 kernelIndex = 0; kernelIndex <= u32(supportedKernel); ++kernelIndex)
+		{
+			QuantizationKernel kernel = QuantizationKernel(kernelIndex);
+
+			std::vector<Vertex> vertices(rawVertices.size());
+			f64 bestTime = DBL_MAX;
+
+			for (u32 iterationIndex = 0; iterationIndex < iterationCount; ++iterationIndex)
+			{
+				auto startTime = std::chrono::high_resolution_clock::now();
+
+				QuantizationFrame frame = calculateQuantizationFrame(rawVertices.data(), rawVertices.size(), kernel);
+				quantizeVertices(rawVertices.data(), rawVertices.size(), frame, vertices.data(), kernel);
+
+				auto endTime = std::chrono::high_resolution_clock::now();
+				bestTime = glm::min(bestTime, std::chrono::duration<f64, std::chrono::milliseconds::period>(endTime - startTime).count());
+			}
+
+			if (kernel == QuantizationKernel::Scalar)
+			{
+				referenceVertices = vertices;
+				scalarTime = bestTime;
+			}
+			else if (memcmp(vertices.data(), referenceVertices.data(), sizeof(Vertex) * vertices.size()) != 0)
+			{
+				fprintf(stderr, "%s kernel output doesn't match the scalar kernel.\n", getQuantizationKernelName(kernel));
+				bMismatch = true;
+			}
+
+			printf("  %-6s %8.3f ms, %8.1f Mvertices/s, %5.2fx\n", getQuantizationKernelName(kernel), bestTime,
+				1e-3 * f64(rawVertices.size()) / bestTime, scalarTime / bestTime);
+		}
+	}
+
+	return bMismatch ? 1 : 0;
+}